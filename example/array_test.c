@@ -0,0 +1,277 @@
+#include "check.h"
+
+// Packed `[ ... ]` arrays, through every way of loading them: integers and
+// decimals packed plain, anything mixed as y_value_t, element notes, empty
+// arrays, optional commas, elements past what fits on the stack, and broken
+// arrays reported as Y_ERROR_SYNTAX.
+
+// The array of node `a` in `text`, loaded the given way.
+static y_node_t *array_of(yctx_t *ctx, cstr text, int way)
+{
+  if (!load_way(ctx, text, strlen(text), way))
+  {
+    fail("%s did not load: %s", load_name(way), text);
+    return NULL;
+  }
+
+  y_node_t *node = y_find(ctx, "a");
+
+  if (!node || node->value.kind != Y_ARRAY)
+  {
+    fail("%s gave no array: %s", load_name(way), text);
+    return NULL;
+  }
+
+  return node;
+}
+
+static void check_integers(cstr text, const u64 *expect, u64 count)
+{
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *node = array_of(&ctx, text, way);
+    u64 length;
+
+    if (node)
+    {
+      const u64 *items = y_integers(node, &length);
+
+      if (!items || length != count || memcmp(items, expect, count * sizeof(u64)) || y_decimals(node, &length) || y_values(node, &length))
+        fail("%s packed the integers wrong: %s", load_name(way), text);
+    }
+
+    y_delete(&ctx);
+  }
+}
+
+static void check_decimals(cstr text, const f64 *expect, u64 count)
+{
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *node = array_of(&ctx, text, way);
+    u64 length;
+
+    if (node)
+    {
+      const f64 *items = y_decimals(node, &length);
+
+      if (!items || length != count || memcmp(items, expect, count * sizeof(f64)) || y_integers(node, &length))
+        fail("%s packed the decimals wrong: %s", load_name(way), text);
+    }
+
+    y_delete(&ctx);
+  }
+}
+
+static void check_values(cstr text, const y_value_t *expect, u64 count)
+{
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *node = array_of(&ctx, text, way);
+    u64 length;
+
+    if (node)
+    {
+      const y_value_t *items = y_values(node, &length);
+      bool same = items && length == count && !y_integers(node, &length) && !y_decimals(node, &length);
+
+      for (u64 i = 0; same && i < count; i++)
+        same = same_value(&items[i], &expect[i]);
+
+      if (!same)
+        fail("%s packed the values wrong: %s", load_name(way), text);
+    }
+
+    y_delete(&ctx);
+  }
+}
+
+// An empty array has no type to pack, so it is one of values, none of them.
+static void check_empty(cstr text)
+{
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *node = array_of(&ctx, text, way);
+    u64 length = 1;
+
+    if (node && (node->value.array->type != Y_NONE || node->value.array->length || (y_values(node, &length), length) || y_integers(node, &length)))
+      fail("%s gave a non-empty array: %s", load_name(way), text);
+
+    y_delete(&ctx);
+  }
+}
+
+// `notes` names the one note of each element, NULL for none.
+static void check_notes(cstr text, const cstr *notes, u64 count)
+{
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *node = array_of(&ctx, text, way);
+
+    if (node)
+    {
+      const y_array_t *array = node->value.array;
+      bool same = array->length == count && array->notes;
+
+      for (u64 i = 0; same && i < count; i++)
+      {
+        y_note_t *note = array->notes[i];
+
+        same = notes[i] ? note && !note->next && same_string(note->name, string_view(notes[i])) : !note;
+      }
+
+      if (!same)
+        fail("%s lost element notes: %s", load_name(way), text);
+    }
+
+    y_delete(&ctx);
+  }
+}
+
+static void check_broken(cstr text)
+{
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *head = load_way(&ctx, text, strlen(text), way);
+    u64 count;
+    const y_diag_t *diags = y_diagnostics(&ctx, &count);
+
+    if (head || !count || diags[0].code != Y_ERROR_SYNTAX)
+      fail("%s took a broken array: %s", load_name(way), text);
+
+    y_delete(&ctx);
+  }
+}
+
+// A `\r` is no blank to the lexer, in an array or out of one, so a CRLF text
+// fails at the same byte however it is loaded.
+static void check_crlf(cstr text)
+{
+  yctx_t whole = y_create();
+
+  load_way(&whole, text, strlen(text), 0);
+
+  for (int way = 0; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *head = load_way(&ctx, text, strlen(text), way);
+    u64 count;
+    const y_diag_t *diags = y_diagnostics(&ctx, &count);
+
+    if (head || !count || diags[0].code != Y_ERROR_CHARACTER || !same_diags(&ctx, &whole))
+      fail("%s loads a CRLF array its own way", load_name(way));
+
+    y_delete(&ctx);
+  }
+
+  y_delete(&whole);
+}
+
+#define LARGE (3 * 1024 * 1024) // Past the size Y_LOAD_PARALLEL splits at
+
+// A large root of arrays of every shape gives one tree whichever way it loads.
+static void check_large(void)
+{
+  char *text = malloc(LARGE + 256), *ch = text;
+  u64 state = 1;
+
+  ch += sprintf(ch, "root {\n");
+
+  for (int i = 0; ch - text < LARGE; i++)
+  {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    switch (i % 4)
+    {
+    case 0: ch += sprintf(ch, "  i%d [ %llu, %llu, 3 ]\n", i, (unsigned long long) (state >> 40), (unsigned long long) (state >> 12)); break;
+    case 1: ch += sprintf(ch, "  d%d [ %llu.%llu 0.5 ]\n", i, (unsigned long long) (state >> 50), (unsigned long long) (state >> 44)); break;
+    case 2: ch += sprintf(ch, "  m%d [ 1 \"s%d\" 2.5, ]\n", i, i); break;
+    default: ch += sprintf(ch, "  n%d [ 1 @x 2, 3 @y ]\n", i); break;
+    }
+  }
+
+  ch += sprintf(ch, "}\n");
+
+  u64 length = ch - text;
+  yctx_t whole = y_create();
+  y_node_t *expect = y_parse_buffer(&whole, text, length, "large");
+
+  for (int way = 1; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *head = load_way(&ctx, text, length, way);
+
+    if (!expect || !head || !same_tree(head, expect))
+      fail("%s gave another tree for a large file of arrays", load_name(way));
+
+    y_delete(&ctx);
+  }
+
+  y_delete(&whole);
+  free(text);
+}
+
+int main(void)
+{
+  static const u64 small[] = { 1, 2, 3 };
+  static const u64 wide[] = { 12345678901234567890ULL, 0, 1000000, 18446744073709551615ULL };
+  static const f64 halves[] = { 1.5, 2.25, 0.125 };
+  static const cstr notes[] = { "x", NULL, "y" };
+  u64 many[100];
+  char text[1024], *ch = text;
+
+  check_integers("a [ 1, 2, 3 ]", small, 3);
+  check_integers("a [1 2 3]", small, 3);
+  check_integers("a [ 1,\n  2,\n  3, ]", small, 3);
+  check_integers("a [ 1_2345_6789_0123_4567_890 0 1_000_000 18446744073709551615 ]", wide, 4);
+  check_decimals("a [ 1.5, 2.25, 0.125 ]", halves, 3);
+  check_decimals("a [ 1.5 2.2_5 0.12_5 ]", halves, 3);
+
+  check_values("a [ 1 \"two\" 3.5 ]", (y_value_t[])
+  {
+    { .kind = Y_INTEGER, .integer = 1 },
+    { .kind = Y_STRING, .string = string_view("two") },
+    { .kind = Y_DECIMAL, .decimal = 3.5 },
+  }, 3);
+
+  check_values("a [ 1, 2, 3, 4.5 ]", (y_value_t[])
+  {
+    { .kind = Y_INTEGER, .integer = 1 },
+    { .kind = Y_INTEGER, .integer = 2 },
+    { .kind = Y_INTEGER, .integer = 3 },
+    { .kind = Y_DECIMAL, .decimal = 4.5 },
+  }, 4);
+
+  check_empty("a [ ]");
+  check_empty("a [\n]");
+
+  check_notes("a [ 1 @x, 2, 3 @y ]", notes, 3);
+  check_notes("a [ \"s\" @x 2.5 3 @y ]", notes, 3);
+
+  // More than the 64 elements staged on the stack
+  ch += sprintf(ch, "a [");
+
+  for (int i = 0; i < 100; i++)
+    ch += sprintf(ch, " %llu", (unsigned long long) (many[i] = i * 7919));
+
+  sprintf(ch, " ]");
+  check_integers(text, many, 100);
+
+  check_broken("a [ 1 { ] }");
+  check_broken("a [ 1 2");
+  check_broken("a [ 1 b 2 ]");
+
+  check_crlf("x [1\r\n2]");
+  check_crlf("x [ 1,\r\n  2 ]\r\n");
+  check_crlf("x { a [ 1 2 ]\r\n}");
+
+  check_large();
+
+  return finish();
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "check.h"
+
+// Atoms live as long as a unit loaded holds them: unloading the last unit
+// that uses a name takes its atom out, one another unit shares stays with
+// its number, and numbers are never handed out twice. y_has finds notes
+// through the atoms too.
+
+static y_node_t *parse(yctx_t *ctx, cstr text)
+{
+  return y_parse_buffer(ctx, text, strlen(text), "atom");
+}
+
+static u32 atom(yctx_t *ctx, cstr name)
+{
+  return y_atom(ctx, string_view(name));
+}
+
+static void check_shared(void)
+{
+  yctx_t ctx = y_create();
+  y_node_t *a = parse(&ctx, "a { x 1 @n }");
+  y_node_t *b = parse(&ctx, "b { x 2 y 3 }");
+  u32 x = atom(&ctx, "x"), n = atom(&ctx, "n"), first = atom(&ctx, "a");
+
+  if (!a || !b || !x || !n || !first)
+  {
+    fail("names loaded have no atoms");
+    y_delete(&ctx);
+    return;
+  }
+
+  y_node_t *child = y_enter(a);
+  y_note_t *note = y_has(child, string_view("n"));
+
+  if (y_node_atom(a) != first || y_node_atom(child) != x || y_node_atom(y_enter(b)) != x)
+    fail("a node's atom is not the atom of its name");
+
+  if (!note || y_note_atom(note) != n || y_has_atom(child, n) != note)
+    fail("a note is not found by its name");
+
+  if (y_has(child, string_view("y")) || y_has(child, string_view("nothing")))
+    fail("a note is found on a node without it");
+
+  y_unload(&ctx, a);
+
+  if (atom(&ctx, "a") || atom(&ctx, "n"))
+    fail("names of an unloaded unit keep their atoms");
+
+  if (atom(&ctx, "x") != x || !atom(&ctx, "y"))
+    fail("names a loaded unit holds lost their atoms");
+
+  a = parse(&ctx, "a { }");
+
+  if (!a || y_node_atom(a) <= first)
+    fail("an atom number was handed out again");
+
+  y_delete(&ctx);
+}
+
+// Loading and unloading names never seen again leaves none of them behind.
+static void check_churn(void)
+{
+  yctx_t ctx = y_create();
+  y_node_t *keep = parse(&ctx, "keep { shared 1 }");
+  char text[64], name[32];
+
+  for (int i = 0; i < 20000; i++)
+  {
+    snprintf(text, sizeof(text), "unit%d { shared 1 name%d 2 @note%d }", i, i, i);
+
+    y_node_t *head = parse(&ctx, text);
+
+    if (!head)
+    {
+      fail("a unit did not load");
+      break;
+    }
+
+    y_unload(&ctx, head);
+  }
+
+  for (int i = 0; i < 20000; i += 997)
+  {
+    snprintf(name, sizeof(name), "name%d", i);
+
+    if (atom(&ctx, name))
+      fail("a name of an unloaded unit is still interned");
+  }
+
+  if (!keep || !atom(&ctx, "shared") || !atom(&ctx, "keep"))
+    fail("the names of the unit kept were lost");
+
+  if (ctx.units->length != 1)
+    fail("the context still lists %llu units", (unsigned long long) ctx.units->length);
+
+  y_delete(&ctx);
+}
+
+int main(void)
+{
+  check_shared();
+  check_churn();
+
+  return finish();
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <liby/y.h>
+#include <stdio.h>
+#include <time.h>
+
+// Loads a deeply indented, comment-heavy file and prints the best y_load
+// throughput of a few runs. Only y_create, y_load and y_delete are used, so
+// the same file builds against older trees for a before/after comparison.
+
+#define LINES 100000
+#define RUNS  5
+
+static double now(void)
+{
+  struct timespec ts;
+
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long generate(cstr path)
+{
+  FILE *file = fopen(path, "wb");
+
+  if (!file)
+    return -1;
+
+  fprintf(file, "bench\n{\n");
+
+  for (int i = 0; i < LINES; i++)
+  {
+    fprintf(file, "%*s", 480, "");
+
+    for (int tab = 0; tab < 40; tab++)
+      fputc('\t', file);
+
+    if (i % 4 == 0)
+      fprintf(file, "// indented comment %d\n%*s", i, 240, "");
+
+    fprintf(file, "key%d %d\n", i % 64, i);
+  }
+
+  fprintf(file, "}\n");
+
+  long size = ftell(file);
+  fclose(file);
+
+  return size;
+}
+
+static double load(cstr path)
+{
+  yctx_t ctx = y_create();
+  double begin = now();
+  y_node_t *head = y_load(&ctx, path);
+  double seconds = now() - begin;
+
+  y_delete(&ctx);
+
+  return head ? seconds : -1;
+}
+
+int main(int argc, char **argv)
+{
+  cstr path = argc > 1 ? argv[1] : "blank_bench.y";
+  long size = generate(path);
+
+  if (size < 0)
+  {
+    printf("cannot write %s\n", path);
+    return 1;
+  }
+
+  double best = 0;
+
+  for (int run = 0; run < RUNS; run++)
+  {
+    double seconds = load(path);
+
+    if (seconds < 0)
+    {
+      printf("%s did not load\n", path);
+      return 1;
+    }
+
+    if (!best || seconds < best)
+      best = seconds;
+  }
+
+  printf("%.1f MB in %.1f ms: %.0f MB/s\n", size / 1e6, best * 1e3, size / 1e6 / best);
+  remove(path);
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "check.h"
+#include <pthread.h>
+
+// Blank runs in front of a stray `$`: the error must land on the line and
+// column the run leaves off at, however the run lines up with the 16 and 32
+// byte blocks the lexer skips in.
+
+// Parses `length` bytes copied into a block of exactly that size, so that a
+// read past the end is caught under a sanitizer.
+static y_node_t *parse(yctx_t *ctx, const char *text, u64 length, char **data)
+{
+  *data = malloc(length);
+  memcpy(*data, text, length);
+
+  return y_parse_buffer(ctx, *data, length, "blank");
+}
+
+static void check_error(const char *text, u64 length, uint line, uint column)
+{
+  yctx_t ctx = y_create();
+  char *data;
+  u64 count;
+
+  if (parse(&ctx, text, length, &data))
+    fail("error after a blank run loaded (%llu bytes)", (unsigned long long) length);
+
+  const y_diag_t *diags = y_diagnostics(&ctx, &count);
+
+  if (count != 1 || diags[0].code != Y_ERROR_CHARACTER || diags[0].line != line || diags[0].column != column)
+    fail("error after a blank run misplaced (%llu bytes)", (unsigned long long) length);
+
+  y_delete(&ctx);
+  free(data);
+}
+
+static void check_value(const char *text, u64 length, cstr path, u64 value)
+{
+  yctx_t ctx = y_create();
+  char *data;
+  y_node_t *node = parse(&ctx, text, length, &data) ? y_find(&ctx, path) : NULL;
+
+  if (!node || node->value.kind != Y_INTEGER || node->value.integer != value)
+    fail("%s (%llu bytes)", path, (unsigned long long) length);
+
+  y_delete(&ctx);
+  free(data);
+}
+
+// Every run length across the first few blocks, ending in blanks or a new
+// line, followed by a token, a comment or the end of the input.
+static void check_runs(void)
+{
+  static const char blanks[] = " \t ";
+  char text[256];
+
+  for (u64 run = 1; run < 160; run++)
+  {
+    for (int newline = 0; newline < 3; newline++)
+    {
+      u64 length = 0;
+      uint line = 1, column = 0;
+
+      text[length++] = 'a';
+      text[length++] = ' ';
+      text[length++] = '1';
+      column = 3;
+
+      for (u64 i = 0; i < run; i++)
+      {
+        bool lf = newline == 1 ? i + 1 == run : newline == 2 && i % 7 == 6;
+
+        text[length++] = lf ? '\n' : blanks[i % 3];
+        column = lf ? 0 : column + 1;
+        line += lf;
+      }
+
+      check_value(text, length, "a", 1);
+
+      text[length++] = '$';
+      check_error(text, length, line, column);
+
+      memcpy(text + length - 1, "// x", 4);
+      check_value(text, length + 3, "a", 1);
+    }
+  }
+}
+
+#define LARGE (8 * 1024 * 1024)
+
+// A multi-megabyte blank region used to recurse once per byte; it is lexed on
+// a thread with a small stack to keep it that way.
+static void *check_large(void *unused)
+{
+  char *text = malloc(LARGE + 8);
+  u64 length = 0;
+  uint lines = 0;
+
+  (void) unused;
+
+  memcpy(text, "a 1", 3);
+  length = 3;
+
+  for (u64 i = 0; i < LARGE; i++)
+  {
+    text[length++] = i % 61 == 60 ? '\n' : i % 5 ? ' ' : '\t';
+    lines += text[length - 1] == '\n';
+  }
+
+  u64 column = 0;
+
+  while (text[length - 1 - column] != '\n')
+    column++;
+
+  check_value(text, length, "a", 1);
+
+  text[length++] = '$';
+  check_error(text, length, 1 + lines, column);
+
+  free(text);
+  return NULL;
+}
+
+int main(void)
+{
+  pthread_attr_t attr;
+  pthread_t thread;
+
+  check_runs();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, 64 * 1024);
+  pthread_create(&thread, &attr, check_large, NULL);
+  pthread_join(thread, NULL);
+
+  return finish();
+}
\ No newline at end of file
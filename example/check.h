@@ -0,0 +1,214 @@
+#ifndef _EXAMPLE_CHECK_h
+#define _EXAMPLE_CHECK_h
+
+#include <liby/y.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Shared by the example/*_test.c programs: counting failures, loading one
+// text through every way y has of loading it, and comparing what that gives.
+
+static int failures;
+
+static inline void fail(cstr format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  printf("FAIL ");
+  vprintf(format, args);
+  printf("\n");
+  va_end(args);
+
+  failures++;
+}
+
+// The last line of a test, which check.sh prints after its name, and the
+// exit status of main.
+static inline int finish(void)
+{
+  printf("%s: %d failures\n", failures ? "FAIL" : "ok", failures);
+  return failures != 0;
+}
+
+// Loads with flags only come from files, so `text` goes through a temporary one.
+static inline y_node_t *load_file(yctx_t *ctx, const char *text, u64 length, y_flag flags)
+{
+  char path[] = "/tmp/y_test_XXXXXX";
+  int fd = mkstemp(path);
+
+  if (fd < 0 || write(fd, text, length) != (long) length)
+    return NULL;
+
+  close(fd);
+
+  y_node_t *head = y_load_with(ctx, path, flags);
+
+  unlink(path);
+  return head;
+}
+
+// Hands out `first` bytes on the first read and `chunk` on each one after.
+typedef struct feed_t
+{
+  const char *text;
+  u64 length, at, first, chunk;
+} feed_t;
+
+static inline u64 feed_read(void *user, char *buffer, u64 size)
+{
+  feed_t *feed = user;
+  u64 count = feed->at ? feed->chunk : feed->first;
+
+  if (count > size)
+    count = size;
+
+  if (count > feed->length - feed->at)
+    count = feed->length - feed->at;
+
+  memcpy(buffer, feed->text + feed->at, count);
+  feed->at += count;
+
+  return count;
+}
+
+static inline y_node_t *load_stream(yctx_t *ctx, const char *text, u64 length, u64 first, u64 chunk)
+{
+  feed_t feed = { text, length, 0, first, chunk };
+
+  return y_load_stream(ctx, feed_read, &feed, "stream");
+}
+
+// Every way of loading a text, see load_way.
+#define LOADS 8
+
+static inline cstr load_name(int way)
+{
+  static const cstr names[LOADS] =
+  {
+    "y_parse_buffer", "y_load", "Y_LOAD_MAPPED", "Y_LOAD_FLAT", "Y_LOAD_PARALLEL",
+    "Y_LOAD_LAZY", "y_load_stream by 1 byte", "y_load_stream by 7 bytes",
+  };
+
+  return names[way];
+}
+
+// A Y_LOAD_PARALLEL text below the size it splits at is parsed serially.
+static inline y_node_t *load_way(yctx_t *ctx, const char *text, u64 length, int way)
+{
+  switch (way)
+  {
+  case 0: return y_parse_buffer(ctx, text, length, "buffer");
+  case 1: return load_file(ctx, text, length, 0);
+  case 2: return load_file(ctx, text, length, Y_LOAD_MAPPED);
+  case 3: return load_file(ctx, text, length, Y_LOAD_FLAT);
+  case 4: return load_file(ctx, text, length, Y_LOAD_PARALLEL);
+  case 5: return load_file(ctx, text, length, Y_LOAD_LAZY);
+  case 6: return load_stream(ctx, text, length, 1, 1);
+  default: return load_stream(ctx, text, length, 7, 7);
+  }
+}
+
+static inline bool same_string(string_t a, string_t b)
+{
+  return a.length == b.length && !memcmp(a.string, b.string, a.length);
+}
+
+static inline bool same_notes(y_note_t *a, y_note_t *b)
+{
+  for (; a && b; a = a->next, b = b->next)
+  {
+    if (!same_string(a->name, b->name))
+      return false;
+  }
+
+  return !a && !b;
+}
+
+// Decimals bit for bit, so that a NaN or a -0 is told apart too.
+static inline bool same_value(const y_value_t *a, const y_value_t *b)
+{
+  if (a->kind != b->kind)
+    return false;
+
+  switch (a->kind)
+  {
+  case Y_STRING:  return same_string(a->string, b->string);
+  case Y_INTEGER: return a->integer == b->integer;
+  case Y_DECIMAL: return !memcmp(&a->decimal, &b->decimal, sizeof(f64));
+  default:        return true;
+  }
+}
+
+static inline bool same_array(const y_array_t *a, const y_array_t *b)
+{
+  if (a->type != b->type || a->length != b->length || !a->notes != !b->notes)
+    return false;
+
+  for (u64 i = 0; i < a->length; i++)
+  {
+    if (a->notes && !same_notes(a->notes[i], b->notes[i]))
+      return false;
+
+    if (a->type == Y_INTEGER && a->integers[i] != b->integers[i])
+      return false;
+
+    if (a->type == Y_DECIMAL && memcmp(&a->decimals[i], &b->decimals[i], sizeof(f64)))
+      return false;
+
+    if (a->type == Y_NONE && !same_value(&a->values[i], &b->values[i]))
+      return false;
+  }
+
+  return true;
+}
+
+// Whether the siblings from `a` and `b` hold the same names, notes, values
+// and children; bodies are entered first, as `count` is only known once a
+// lazy one has been parsed.
+static inline bool same_tree(y_node_t *a, y_node_t *b)
+{
+  for (; a && b; a = a->next, b = b->next)
+  {
+    y_node_t *first = y_enter(a), *other = y_enter(b);
+
+    if (!same_string(a->name, b->name) || !same_notes(a->note, b->note) || a->value.kind != b->value.kind)
+      return false;
+
+    if (a->value.kind == Y_NODE && (a->count != b->count || !same_tree(first, other)))
+      return false;
+
+    if (a->value.kind == Y_ARRAY && !same_array(a->value.array, b->value.array))
+      return false;
+
+    if (a->value.kind != Y_NODE && a->value.kind != Y_ARRAY && !same_value(&a->value, &b->value))
+      return false;
+  }
+
+  return !a && !b;
+}
+
+// Whether two contexts hold the same diagnostics, down to their byte ranges.
+static inline bool same_diags(yctx_t *a, yctx_t *b)
+{
+  u64 count, other;
+  const y_diag_t *first = y_diagnostics(a, &count), *second = y_diagnostics(b, &other);
+
+  if (count != other)
+    return false;
+
+  for (u64 i = 0; i < count; i++)
+  {
+    if (first[i].code != second[i].code || first[i].line != second[i].line || first[i].column != second[i].column)
+      return false;
+
+    if (first[i].begin != second[i].begin || first[i].end != second[i].end)
+      return false;
+  }
+
+  return true;
+}
+
+#endif
\ No newline at end of file
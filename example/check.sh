@@ -0,0 +1,28 @@
+#!/bin/sh
+# Builds and runs every example/*_test.c against liby/y.c.
+#   SDK   directory holding the sdk/ headers (required)
+#   LIBS  whatever the sdk needs linked in, if it is not header-only
+#   CC, CFLAGS as usual; try CFLAGS="-fsanitize=address,undefined"
+cd "$(dirname "$0")/.." || exit 1
+
+: "${SDK:?set SDK to the directory holding sdk/}"
+CC=${CC:-cc}
+OUT=${OUT:-${TMPDIR:-/tmp}}
+failed=0
+
+for test in example/*_test.c
+do
+  name=$(basename "$test" .c)
+
+  if ! $CC -std=gnu11 -O2 $CFLAGS -I. -I"$SDK" liby/y.c "$test" -o "$OUT/$name" $LIBS -lpthread -lm
+  then
+    echo "$name: does not build"
+    failed=1
+    continue
+  fi
+
+  printf '%s: ' "$name"
+  "$OUT/$name" || failed=1
+done
+
+exit $failed
@@ -0,0 +1,105 @@
+#include <liby/y.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// A float-heavy corpus, one decimal per node, parsed whole by y_parse_buffer.
+// The same corpus with the `.` taken out shows what the rest of the parse
+// costs, and strtod over the literals, one call each, what the conversion
+// alone would cost through libc.
+
+#define LITERALS 1000000
+#define RUNS     5
+
+static double now(void)
+{
+  struct timespec ts;
+
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double parse(const char *text, u64 length)
+{
+  double best = 0;
+
+  for (int run = 0; run < RUNS; run++)
+  {
+    yctx_t ctx = y_create();
+    double begin = now();
+    y_node_t *head = y_parse_buffer(&ctx, text, length, "floats");
+    double seconds = now() - begin;
+
+    y_delete(&ctx);
+
+    if (!head)
+      return -1;
+
+    if (!best || seconds < best)
+      best = seconds;
+  }
+
+  return best * 1e9 / LITERALS;
+}
+
+int main(void)
+{
+  char *text = malloc(LITERALS * 40 + 32), *ch = text;
+  char *integers = malloc(LITERALS * 40 + 32), *it = integers;
+  char **literals = malloc(LITERALS * sizeof(char *));
+  u64 state = 1;
+
+  ch += sprintf(ch, "floats {\n");
+  it += sprintf(it, "floats {\n");
+
+  // Mostly short fractions, every fourth one 17 digits long
+  for (int i = 0; i < LITERALS; i++)
+  {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    unsigned long long whole = (state >> 40) % 100000;
+    unsigned long long fraction = (state >> 8) % (i % 4 ? 10000 : 1000000000000ULL);
+    int width = i % 4 ? 4 : 12;
+
+    literals[i] = ch + 4;
+    ch += sprintf(ch, "  v %llu.%0*llu\n", whole, width, fraction);
+    it += sprintf(it, "  v %llu%0*llu\n", whole, width, fraction);
+  }
+
+  ch += sprintf(ch, "}\n");
+  it += sprintf(it, "}\n");
+
+  double decimal = parse(text, ch - text);
+  double integer = parse(integers, it - integers);
+  double baseline = 0, sum = 0;
+
+  if (decimal < 0 || integer < 0)
+  {
+    printf("corpus did not load\n");
+    return 1;
+  }
+
+  for (int run = 0; run < RUNS; run++)
+  {
+    double begin = now();
+
+    for (int i = 0; i < LITERALS; i++)
+      sum += strtod(literals[i], NULL);
+
+    double seconds = now() - begin;
+
+    if (!baseline || seconds < baseline)
+      baseline = seconds;
+  }
+
+  printf("%d literals, %.1f MB, per literal:\n", LITERALS, (ch - text) / 1e6);
+  printf("  y_parse_buffer, decimals       %6.1f ns\n", decimal);
+  printf("  y_parse_buffer, as integers    %6.1f ns\n", integer);
+  printf("  strtod alone                   %6.1f ns (%g)\n", baseline * 1e9 / LITERALS, sum);
+
+  free(literals);
+  free(integers);
+  free(text);
+
+  return 0;
+}
\ No newline at end of file
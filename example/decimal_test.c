@@ -0,0 +1,239 @@
+#include "check.h"
+#include <locale.h>
+#include <math.h>
+
+// Decimals against strtod in the "C" locale, bit for bit: random literals of
+// every shape the grammar allows, exact halfway points between neighbouring
+// doubles, and subnormals, which go through the strtod_l fallback. Each batch
+// is parsed twice, as node values and as a packed `[ ... ]`.
+
+#define SAMPLES 400000
+#define BATCH   4096
+#define LITERAL 1200
+
+static u64 state = 0x9E3779B97F4A7C15;
+
+static u64 random64(void)
+{
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+static uint below(uint limit)
+{
+  return random64() % limit;
+}
+
+static char *digits(char *out, uint count)
+{
+  for (uint i = 0; i < count; i++)
+    *out++ = '0' + below(10);
+
+  return out;
+}
+
+// Digits, `_` separators and one `.`, always starting with a digit.
+static void random_literal(char *out)
+{
+  uint shape = below(5);
+  char *ch = out;
+
+  switch (shape)
+  {
+  case 0: // Short, the exact fast path
+    ch = digits(ch, 1 + below(8));
+    *ch++ = '.';
+    ch = digits(ch, 1 + below(8));
+    break;
+  case 1: // Long mantissas, truncated past 19 digits
+    ch = digits(ch, 1 + below(12));
+    *ch++ = '.';
+    ch = digits(ch, 8 + below(24));
+    break;
+  case 2: // Zero padded, small powers
+    *ch++ = '0';
+    *ch++ = '.';
+    memset(ch, '0', shape = below(40));
+    ch = digits(ch + shape, 1 + below(19));
+    break;
+  case 3: // Large integer parts
+    *ch++ = '1' + below(9);
+    ch = digits(ch, 15 + below(20));
+    *ch++ = '.';
+    ch = digits(ch, below(4));
+    break;
+  default: // Separators anywhere after the first digit
+    *ch++ = '1' + below(9);
+
+    for (uint i = below(24); i; i--)
+      *ch++ = below(4) ? '0' + below(10) : '_';
+
+    *ch++ = '.';
+
+    for (uint i = 1 + below(12); i; i--)
+      *ch++ = below(4) ? '0' + below(10) : '_';
+    break;
+  }
+
+  *ch = 0;
+}
+
+// The exact decimal midway between `value` and the next double up; long double
+// holds it exactly and glibc prints it exactly. `above` nudges it past.
+static void halfway_literal(char *out, double value, bool above)
+{
+  long double next = nextafter(value, INFINITY);
+  long double middle = ((long double) value + next) / 2;
+  int length = snprintf(out, LITERAL - 2, "%.1100Lf", middle);
+
+  while (out[length - 1] == '0' && out[length - 2] != '.')
+    length--;
+
+  if (above)
+    out[length++] = '1';
+
+  out[length] = 0;
+}
+
+static void special_literal(char *out, u64 i)
+{
+  switch (i % 6)
+  {
+  case 0: // Subnormals, a few hundred bytes of zeros in
+  {
+    uint zeros = 307 + below(16);
+
+    strcpy(out, "0.");
+    memset(out + 2, '0', zeros);
+    *digits(out + 2 + zeros, 1 + below(30)) = 0;
+    break;
+  }
+  case 1: // Halfway between two subnormals
+    halfway_literal(out, ldexp((double) (1 + below(1u << 20)), -1074), false);
+    break;
+  case 2: // Halfway between two normals, ties to even
+    halfway_literal(out, ldexp((double) ((random64() >> 11) | 1ull << 52), -52 - (int) below(80)), false);
+    break;
+  case 3: // Just past halfway, rounds up
+    halfway_literal(out, ldexp((double) ((random64() >> 11) | 1ull << 52), -52 + (int) below(60)), true);
+    break;
+  case 4: // Past DBL_MAX, rounds to infinity
+    out[0] = '1' + below(9);
+    strcpy(digits(out + 1, 308 + below(4)), ".5");
+    break;
+  default: // The smallest subnormal, or just past the halfway below it
+    strcpy(out, "0.");
+    memset(out + 2, '0', 324);
+    strcpy(out + 325, "5");
+
+    if (below(2))
+      strcpy(out + 326, "2470328229206232720882");
+    break;
+  }
+}
+
+static double reference(const char *literal)
+{
+  char copy[LITERAL], *it = copy;
+
+  for (; *literal; literal++)
+  {
+    if (*literal != '_')
+      *it++ = *literal;
+  }
+
+  *it = 0;
+  return strtod(copy, NULL);
+}
+
+static bool same(double a, double b)
+{
+  return !memcmp(&a, &b, sizeof(a));
+}
+
+static void check_batch(char (*literals)[LITERAL], uint count)
+{
+  u64 size = 32 + count * (LITERAL + 8) * 2;
+  char *text = malloc(size), *ch = text;
+
+  ch += sprintf(ch, "batch {\n");
+
+  for (uint i = 0; i < count; i++)
+    ch += sprintf(ch, "  v %s\n", literals[i]);
+
+  ch += sprintf(ch, "  packed [");
+
+  for (uint i = 0; i < count; i++)
+    ch += sprintf(ch, " %s", literals[i]);
+
+  ch += sprintf(ch, " ]\n}\n");
+
+  yctx_t ctx = y_create();
+  y_node_t *head = y_parse_buffer(&ctx, text, ch - text, "decimal");
+  y_node_t *it = head ? y_enter(head) : NULL;
+  u64 length = 0;
+  const f64 *packed = y_decimals(y_find(&ctx, "batch packed"), &length);
+
+  if (!head || length != count)
+  {
+    const y_diag_t *diags = y_diagnostics(&ctx, &length);
+
+    fail("batch did not load: %s", length ? diags[0].message : "");
+  }
+
+  for (uint i = 0; i < count && it; i++, it = it->next)
+  {
+    double expect = reference(literals[i]);
+
+    if (it->value.kind != Y_DECIMAL || !same(it->value.decimal, expect) || (packed && !same(packed[i], expect)))
+    {
+      if (failures < 10)
+        fail("%s: %a, packed %a, strtod %a", literals[i], it->value.decimal, packed ? packed[i] : 0.0, expect);
+      else
+        failures++;
+    }
+  }
+
+  y_delete(&ctx);
+  free(text);
+}
+
+// A literal must not depend on the locale the process runs in.
+static void check_locale(void)
+{
+  if (!setlocale(LC_NUMERIC, "de_DE.UTF-8") && !setlocale(LC_NUMERIC, "fr_FR.UTF-8"))
+    return;
+
+  yctx_t ctx = y_create();
+  y_node_t *head = y_parse_buffer(&ctx, "v 1.5", 5, "locale");
+
+  if (!head || head->value.kind != Y_DECIMAL || head->value.decimal != 1.5)
+    fail("1.5 under a `,` decimal locale");
+
+  y_delete(&ctx);
+  setlocale(LC_NUMERIC, "C");
+}
+
+int main(void)
+{
+  static char literals[BATCH][LITERAL];
+
+  for (u64 done = 0; done < SAMPLES; done += BATCH)
+  {
+    for (uint i = 0; i < BATCH; i++)
+    {
+      if (i % 8)
+        random_literal(literals[i]);
+      else
+        special_literal(literals[i], (done + i) / 8);
+    }
+
+    check_batch(literals, BATCH);
+  }
+
+  check_locale();
+
+  return finish();
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "check.h"
+#include <pthread.h>
+
+// A million levels of `n { ... }` load on a thread with a 64 KiB stack, as
+// the parser keeps its own; yctx_t::depth turns one list too many into
+// Y_ERROR_DEPTH at the `{` that opens it.
+
+#define LEVELS 1000000
+
+// `n { n { ... n 1 ... } }`, `levels` names deep, each on its own line.
+static char *nest(u64 levels, u64 *length)
+{
+  char *text = malloc(levels * 5 + 8), *ch = text;
+
+  for (u64 i = 1; i < levels; i++)
+  {
+    memcpy(ch, "n {\n", 4);
+    ch += 4;
+  }
+
+  memcpy(ch, "n 1\n", 4);
+  ch += 4;
+
+  for (u64 i = 1; i < levels; i++)
+    *ch++ = '}';
+
+  *length = ch - text;
+  return text;
+}
+
+static u64 depth_of(y_node_t *node)
+{
+  u64 depth = 1;
+
+  while (node->value.kind == Y_NODE)
+  {
+    node = y_enter(node);
+    depth++;
+  }
+
+  return node->value.kind == Y_INTEGER && node->value.integer == 1 ? depth : 0;
+}
+
+static void *check_deep(void *unused)
+{
+  u64 length;
+  char *text = nest(LEVELS, &length);
+  yctx_t ctx = y_create();
+  y_node_t *head = y_parse_buffer(&ctx, text, length, "deep");
+
+  (void) unused;
+
+  if (!head)
+    fail("a million levels did not load");
+  else if (depth_of(head) != LEVELS)
+    fail("a million levels lost some");
+
+  y_delete(&ctx);
+  free(text);
+
+  return NULL;
+}
+
+// `braces` lists deep, against a limit of `limit` open at once.
+static void check_limit(uint limit, u64 braces)
+{
+  u64 length, count;
+  char *text = nest(braces + 1, &length);
+  yctx_t ctx = y_create();
+
+  ctx.depth = limit;
+
+  y_node_t *head = y_parse_buffer(&ctx, text, length, "limit");
+  const y_diag_t *diags = y_diagnostics(&ctx, &count);
+
+  if (braces <= limit && (!head || depth_of(head) != braces + 1))
+    fail("nesting up to the limit did not load");
+
+  // Line i opens the i-th list
+  if (braces > limit && (head || !count || diags[0].code != Y_ERROR_DEPTH || diags[0].line != limit + 1 || diags[0].column != 2))
+    fail("nesting past the limit was not Y_ERROR_DEPTH at its `{`");
+
+  y_delete(&ctx);
+  free(text);
+}
+
+int main(void)
+{
+  pthread_attr_t attr;
+  pthread_t thread;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, 64 * 1024);
+  pthread_create(&thread, &attr, check_deep, NULL);
+  pthread_join(thread, NULL);
+
+  check_limit(1, 1);
+  check_limit(1, 2);
+  check_limit(100, 100);
+  check_limit(100, 101);
+  check_limit(100, LEVELS);
+  check_limit(LEVELS, LEVELS);
+
+  return finish();
+}
\ No newline at end of file
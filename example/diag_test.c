@@ -0,0 +1,128 @@
+#include "check.h"
+
+// Broken texts report every error they hold, in order and at the byte they
+// start at: the parser resyncs after each one and goes on, and the load as a
+// whole returns NULL. Each way of loading reports the same diagnostics; a
+// Y_LOAD_LAZY one reports those of a body when it is entered.
+
+typedef struct expect_t
+{
+  y_error code;
+  uint line, column;
+} expect_t;
+
+// Enters every body, so that a lazy load has parsed all it deferred.
+static void enter_all(y_node_t *node)
+{
+  for (; node; node = node->next)
+    enter_all(y_enter(node));
+}
+
+static void check_diags(cstr text, const expect_t *expect, u64 count)
+{
+  yctx_t whole = y_create();
+  y_node_t *head = y_parse_buffer(&whole, text, strlen(text), "diag");
+  u64 length;
+  const y_diag_t *diags = y_diagnostics(&whole, &length);
+  bool same = !head && length == count;
+
+  for (u64 i = 0; same && i < count; i++)
+    same = diags[i].code == expect[i].code && diags[i].line == expect[i].line && diags[i].column == expect[i].column;
+
+  if (!same)
+  {
+    fail("unexpected diagnostics for: %s", text);
+
+    for (u64 i = 0; i < length; i++)
+      printf("  %d at %u:%u: %s\n", diags[i].code, diags[i].line, diags[i].column, diags[i].message);
+  }
+
+  for (int way = 1; way < LOADS; way++)
+  {
+    yctx_t ctx = y_create();
+
+    head = load_way(&ctx, text, strlen(text), way);
+
+    if (head && way != 5) // A Y_LOAD_LAZY head is in before its bodies are parsed
+      fail("%s loaded a broken text: %s", load_name(way), text);
+
+    enter_all(head);
+
+    if (!same_diags(&ctx, &whole))
+      fail("%s reports other diagnostics for: %s", load_name(way), text);
+
+    y_delete(&ctx);
+  }
+
+  y_delete(&whole);
+}
+
+// A context that failed a load still loads the next text, and keeps the
+// diagnostics of the first.
+static void check_after(void)
+{
+  yctx_t ctx = y_create();
+  cstr broken = "a { b $ }", good = "a { b 1 }";
+  u64 count;
+
+  if (y_parse_buffer(&ctx, broken, strlen(broken), "broken"))
+    fail("a broken text loaded");
+
+  y_node_t *head = y_parse_buffer(&ctx, good, strlen(good), "good");
+  y_node_t *node = y_find(&ctx, "a b");
+
+  if (!head || !node || node->value.integer != 1)
+    fail("a text did not load after a broken one");
+
+  y_diagnostics(&ctx, &count);
+
+  if (count != 1)
+    fail("the context holds %llu diagnostics, not 1", (unsigned long long) count);
+
+  y_delete(&ctx);
+}
+
+int main(void)
+{
+  check_diags(
+    "a {\n"
+    "  b $ 1\n"
+    "  c \"unclosed\n"
+    "  d { e 1 ] f 2 }\n"
+    "  g 1.2.3\n"
+    "  h { i 1\n"
+    "}\n", (expect_t[])
+  {
+    { Y_ERROR_CHARACTER, 2, 4 },
+    { Y_ERROR_STRING, 3, 13 },
+    { Y_ERROR_SYNTAX, 4, 10 },
+    { Y_ERROR_NUMBER, 5, 7 },
+    { Y_ERROR_UNCLOSED, 8, 0 },
+  }, 5);
+
+  check_diags(
+    "r {\n"
+    "  a \"x\\q\"\n"
+    "  b 99999999999999999999\n"
+    "  c [ 1 { ]\n"
+    "  d 2\n"
+    "  e \"\\u12\"\n"
+    "}\n", (expect_t[])
+  {
+    { Y_ERROR_ESCAPE, 2, 6 },
+    { Y_ERROR_NUMBER, 3, 4 },
+    { Y_ERROR_SYNTAX, 4, 8 },
+    { Y_ERROR_ESCAPE, 6, 5 },
+  }, 4);
+
+  // After the root, anything is out of place
+  check_diags("r {\n  a 1\n}\n}\n", (expect_t[]) { { Y_ERROR_SYNTAX, 4, 0 } }, 1);
+  check_diags("r { a 1 } $", (expect_t[]) { { Y_ERROR_CHARACTER, 1, 10 } }, 1);
+
+  // Deferred by a lazy load until `b` is entered
+  check_diags("r {\n  a 1\n  b {\n    c $\n  }\n  d 2\n}\n", (expect_t[]) { { Y_ERROR_CHARACTER, 4, 6 } }, 1);
+
+  check_after();
+
+  return finish();
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "check.h"
+
+// Y_LOAD_LAZY against an eager load of the same text: bodies that are empty
+// or hold only comments enter to no children and no diagnostics, and every
+// body entered gives the tree the eager load built.
+
+static void check_empty(cstr text, cstr path)
+{
+  yctx_t ctx = y_create();
+  y_node_t *head = load_file(&ctx, text, strlen(text), Y_LOAD_LAZY);
+  y_node_t *node = head ? y_find(&ctx, path) : NULL;
+  u64 count;
+
+  y_diagnostics(&ctx, &count);
+
+  if (!node || node->value.kind != Y_NODE || y_enter(node) || node->count || count)
+    fail("an empty body entered to something: %s", text);
+
+  y_delete(&ctx);
+}
+
+static void check_same(cstr text)
+{
+  yctx_t lazy = y_create(), eager = y_create();
+  y_node_t *a = load_file(&lazy, text, strlen(text), Y_LOAD_LAZY);
+  y_node_t *b = load_file(&eager, text, strlen(text), 0);
+
+  if (!a || !b || !same_tree(a, b))
+    fail("a lazy tree differs from the eager one: %.60s", text);
+
+  y_delete(&lazy);
+  y_delete(&eager);
+}
+
+// `levels` bodies one inside the next, each of which is entered once.
+static void check_deep(u64 levels)
+{
+  char *text = malloc(levels * 6 + 8), *ch = text;
+
+  for (u64 i = 0; i < levels; i++)
+  {
+    memcpy(ch, "n { \n", 5);
+    ch += 5;
+  }
+
+  memcpy(ch, "x 1 ", 4);
+  ch += 4;
+
+  for (u64 i = 0; i < levels; i++)
+    *ch++ = '}';
+
+  *ch = 0;
+  check_same(text);
+  free(text);
+}
+
+int main(void)
+{
+  check_empty("a { }", "a");
+  check_empty("a {}", "a");
+  check_empty("a {\n}", "a");
+  check_empty("a {\n  // x\n}", "a");
+  check_empty("a { // x\n}", "a");
+  check_empty("a {\n  // x\n  // y\n\n}", "a");
+  check_empty("a { b { } c 1 }", "a b");
+  check_empty("a { b { // x\n } c 1 }", "a b");
+  check_empty("a { b { c { } } }", "a b c");
+
+  check_same("a { b { } c { // x\n } d { e 1 f { g 2 } } h 3 }");
+  check_same("a { b { c { d { e { } } } } f { // only\n // comments\n } g 1 }");
+  check_same("a { b { c 1 } @n d { } @m e 2 }");
+  check_deep(20000);
+
+  return finish();
+}
\ No newline at end of file
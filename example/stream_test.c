@@ -0,0 +1,111 @@
+#include "check.h"
+
+// y_load_stream against y_parse_buffer over the same text: with the first
+// read cut at every byte, so that each token is split at each point once,
+// with reads of a few bytes, and with tokens longer than the window the
+// stream holds. Diagnostics of broken text must match to the byte.
+
+static const char text[] =
+  "settings // the top\n"
+  "{\n"
+  "  name \"quoted \\\"escapes\\\" and \\\\ \\n\" @label\n"
+  "  count 1_234_567 @slider @min\n"
+  "  ratio 12_3.4_56\n"
+  "  ratio2 0.000123456789012345678\n"
+  "  list [ 1, 2, 3 ] @packed\n"
+  "  mixed [ 1 \"two\" 3.5 ]\n"
+  "  nested { deeper { deepest 18446744073709551615 } }\n"
+  "  @note\n"
+  "  after_note 7\n"
+  "  empty { }\n"
+  "}\n";
+
+static const char broken[] =
+  "a {\n"
+  "  b $ 1\n"
+  "  c \"unclosed\n"
+  "  d { e 1 ] f 2 }\n"
+  "  g 1.2.3\n"
+  "  h { i 1\n"
+  "}\n";
+
+// Every cut of the first read, each followed by reads of `chunk` bytes.
+static void check_cuts(const char *data, u64 length, u64 chunk, bool loads)
+{
+  yctx_t whole = y_create();
+  y_node_t *expect = y_parse_buffer(&whole, data, length, "stream");
+
+  if (!expect != !loads)
+    fail("the reference load %s", loads ? "failed" : "succeeded");
+
+  for (u64 first = 1; first <= length; first++)
+  {
+    yctx_t ctx = y_create();
+    y_node_t *head = load_stream(&ctx, data, length, first, chunk);
+
+    if (loads && (!head || !same_tree(head, expect)))
+      fail("a tree differs with the first read cut at %llu, then %llu bytes", (unsigned long long) first, (unsigned long long) chunk);
+
+    if (!loads && (head || !same_diags(&ctx, &whole)))
+      fail("diagnostics differ with the first read cut at %llu, then %llu bytes", (unsigned long long) first, (unsigned long long) chunk);
+
+    y_delete(&ctx);
+  }
+
+  y_delete(&whole);
+}
+
+#define LONG (300 * 1024) // Several times the window a stream holds
+
+// A name, a string and a number each longer than the window, read in chunks
+// that cut them many times over.
+static void check_long(u64 chunk)
+{
+  char *data = malloc(3 * LONG + 64), *ch = data;
+
+  *ch++ = 'n';
+
+  for (u64 i = 0; i < LONG; i++)
+    *ch++ = 'a' + i % 26;
+
+  ch += sprintf(ch, " {\n  s \"");
+
+  for (u64 i = 0; i < LONG; i++)
+    *ch++ = i % 100 == 99 ? ' ' : 'x';
+
+  ch += sprintf(ch, "\"\n  d 1.");
+
+  for (u64 i = 0; i < LONG; i++)
+    *ch++ = '0' + i % 10;
+
+  ch += sprintf(ch, "\n}\n");
+
+  u64 length = ch - data;
+  yctx_t whole = y_create(), ctx = y_create();
+  y_node_t *expect = y_parse_buffer(&whole, data, length, "long");
+  y_node_t *head = load_stream(&ctx, data, length, chunk, chunk);
+
+  if (!expect || !head || !same_tree(head, expect))
+    fail("tokens longer than the window differ in %llu byte reads", (unsigned long long) chunk);
+
+  y_delete(&ctx);
+  y_delete(&whole);
+  free(data);
+}
+
+int main(void)
+{
+  static const u64 chunks[] = { 1, 2, 3, 5, 16, 64, 4096 };
+
+  for (uint i = 0; i < sizeof(chunks) / sizeof(*chunks); i++)
+  {
+    check_cuts(text, sizeof(text) - 1, chunks[i], true);
+    check_cuts(broken, sizeof(broken) - 1, chunks[i], false);
+  }
+
+  check_long(1);
+  check_long(1000);
+  check_long(64 * 1024 - 1);
+
+  return finish();
+}
\ No newline at end of file
@@ -18,6 +18,7 @@ void print_node(y_node_t *node)
   case Y_STRING: printf("%.*s", node->value.string.length, node->value.string.string); break;
   case Y_INTEGER: printf("%d", node->value.integer); break;
   case Y_DECIMAL: printf("%.1f", node->value.decimal); break;
+  case Y_ARRAY: printf("[..]"); break;
   }
 
   printf("\n");
@@ -29,6 +30,18 @@ int main(void)
 
   y_node_t *settings = y_load(&ctx, "example/test.y");
 
+  if (!settings)
+  {
+    u64 count;
+    const y_diag_t *diags = y_diagnostics(&ctx, &count);
+
+    for (u64 i = 0; i < count; i++)
+      printf("%s:%u:%u: %s\n", diags[i].file, diags[i].line, diags[i].column, diags[i].message);
+
+    y_delete(&ctx);
+    return 1;
+  }
+
   if (y_has(settings, string_view("mutable")))
     printf("settings are mutable\n");
   else 
@@ -1,9 +1,31 @@
+#define _GNU_SOURCE
+
 #include <liby/y.h>
 #include <sdk/fs.h>
 
-#include <ctype.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <stdarg.h>
+#include <locale.h>
+
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#define Y_POSIX 1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define Y_X86 1
+#endif
 
 typedef enum token
 {
@@ -22,7 +44,7 @@ typedef enum token
 typedef struct source_t
 {
   uint line;
-  char *start, *begin, *end;
+  const char *start, *begin, *end, *first, *last;
 } source_t;
 
 typedef struct token_t
@@ -32,21 +54,181 @@ typedef struct token_t
   y_value_t value;
 } token_t;
 
+typedef enum class
+{
+  CLASS_START  = 1 << 0, // [A-Za-z_]
+  CLASS_IDENT  = 1 << 1, // [A-Za-z0-9_]
+  CLASS_DIGIT  = 1 << 2, // [0-9]
+  CLASS_NUMBER = 1 << 3, // [0-9_.]
+  CLASS_STRUCT = 1 << 4, // [{}[],@]
+} class;
+
+#define CLASS_ALPHA (CLASS_START | CLASS_IDENT)
+
+static const u8 classes[256] =
+{
+  ['a' ... 'z'] = CLASS_ALPHA,
+  ['A' ... 'Z'] = CLASS_ALPHA,
+  ['0' ... '9'] = CLASS_IDENT | CLASS_DIGIT | CLASS_NUMBER,
+  ['_']         = CLASS_ALPHA | CLASS_NUMBER,
+  ['.']         = CLASS_NUMBER,
+  ['{']         = CLASS_STRUCT,
+  ['}']         = CLASS_STRUCT,
+  ['[']         = CLASS_STRUCT,
+  [']']         = CLASS_STRUCT,
+  [',']         = CLASS_STRUCT,
+  ['@']         = CLASS_STRUCT,
+};
+
+#define is(ch, mask) (classes[(u8) (ch)] & (mask))
+
+#define ARENA_CHUNK (64 * 1024)
+#define ARENA_LIMIT (16 * 1024 * 1024)
+
+typedef struct chunk_t chunk_t;
+
+struct chunk_t
+{
+  chunk_t *next;
+  u64 used, size;
+};
+
+// Bump allocator for the nodes, notes and strings a unit creates while
+// parsing. Chunks double in size up to ARENA_LIMIT, so releasing a unit frees
+// a handful of blocks no matter how many nodes it holds.
+typedef struct arena_t
+{
+  allocator_t *allocator; // Backs the chunks, NULL for the default
+  chunk_t *chunk;
+} arena_t;
+
+typedef enum storage
+{
+  STORAGE_HEAP,   // Read into a buffer owned by the unit
+  STORAGE_MAPPED, // Mapped read-only from the file
+  STORAGE_BORROWED, // Owned by the caller, see y_parse_buffer
+  STORAGE_STREAM,   // Bounded window refilled from a reader while parsing
+} storage;
+
+#define STREAM_WINDOW (64 * 1024)
+
+// The atoms a unit holds a reference to, each once, handed back when it is
+// dropped. A name the unit has seen before is found here, by its hash,
+// without touching the context's table and its counts that other units share.
+typedef struct held_t
+{
+  struct atom_t **slots;
+  u64 mask, count;
+} held_t;
+
 typedef struct unit_t
 {
-  char *data;
-  char *start;
-  int length;
-  int cursor;
+  cstr name;
+  const char *data;
+  const char *start;
+  u64 length;
+  u64 cursor;
   int line;
+  storage storage;
+
+  y_reader read; // Set while a streamed unit has more input
+  void *user;
+  u64 capacity;
+  u64 base;      // Bytes of a streamed input slid out of the window
+
+  arena_t arena;
+  arena_t scratch; // Linked nodes of a Y_LOAD_FLAT unit until they are flattened
+  y_node_t *head;
+  u64 nodes;
+  bool flat;
+  uint depth;     // Deepest nesting allowed, 0 for no limit
+  uint threads;   // Workers for Y_LOAD_PARALLEL, below 2 to parse serially
+  bool lazy;      // Y_LOAD_LAZY: leave `{ ... }` bodies for lazy_enter
+  uint level;     // Nesting of the nodes this parse starts at, for lazy bodies
+  struct unit_t *owner; // Unit whose data, arena and lock lazy bodies belong to
+  buf_t *braces;        // brace_t of every `{` inside its deferred bodies
+  yctx_t *context;      // Interns the names; also where a lazy unit's bodies
+                        // report their problems
+  held_t held;          // Atoms of the names interned so far
+  buf_t *diags;   // y_diag_t found so far, handed to the context by unit_link
+  bool verbose;   // Print each of them as well
+
+#ifdef Y_POSIX
+  pthread_mutex_t lock; // Held while a lazy body is parsed into the arena
+#endif
 
   token_t previous, current;
 } unit_t;
 
+// Where the body of a Y_LOAD_LAZY node lies: from after its `{` up to the
+// matching `}`, and the line and line start the lexer picks up from.
+struct y_lazy_t
+{
+  unit_t *unit;
+  u64 begin, end, start;
+  int line;
+  uint level; // Nesting of the node's children
+};
+
+static void *arena_push(arena_t *arena, u64 size)
+{
+  chunk_t *chunk = arena->chunk;
+
+  size = (size + 7) & ~(u64) 7;
+
+  if (!chunk || chunk->used + size > chunk->size)
+  {
+    u64 capacity = !chunk ? ARENA_CHUNK : chunk->size < ARENA_LIMIT ? chunk->size * 2 : ARENA_LIMIT;
+
+    // A block bigger than the next chunk gets one of its own, filed behind
+    // the current chunk so that what is left of that is not lost.
+    if (chunk && capacity < size)
+    {
+      chunk_t *block = allocate(arena->allocator, sizeof(chunk_t) + size);
+
+      block->next = chunk->next;
+      block->used = block->size = size;
+      chunk->next = block;
+
+      return block + 1;
+    }
+
+    if (capacity < size)
+      capacity = size;
+
+    chunk = allocate(arena->allocator, sizeof(chunk_t) + capacity);
+    chunk->next = arena->chunk;
+    chunk->used = 0;
+    chunk->size = capacity;
+    arena->chunk = chunk;
+  }
+
+  void *data = (char *) (chunk + 1) + chunk->used;
+  chunk->used += size;
+
+  return data;
+}
+
+static void *arena_zero(arena_t *arena, u64 size)
+{
+  return memset(arena_push(arena, size), 0, size);
+}
+
+static void arena_drop(arena_t *arena)
+{
+  for (chunk_t *it = arena->chunk, *next; it; it = next)
+  {
+    next = it->next;
+    deallocate(arena->allocator, it);
+  }
+
+  arena->chunk = NULL;
+}
+
 #define C_FATAL "\033[1;31m"
 #define C_RESET "\033[0m"
 
-static void msg_line(char *ch, const char *col, char *begin, char *end)
+static void msg_line(const char *ch, const char *col, const char *begin, const char *end, const char *last)
 {
   if (!ch)
   {
@@ -54,7 +236,7 @@ static void msg_line(char *ch, const char *col, char *begin, char *end)
     return;
   }
 
-  while (*ch)
+  while (ch < last && *ch)
   {
     if (*ch == '\n')
       break;
@@ -85,351 +267,3644 @@ static void msg_underline(int length)
   fputc(' ', stderr);
 }
 
-static void msg(source_t source, const char *col, const char *format, va_list args)
+static void msg(source_t source, const char *col, cstr message)
 {
   uint padding = 4;
   uint base = (ulong)(source.begin - source.start);
 
   fprintf(stderr, "%*d | ", padding, source.line);
-  msg_line(source.start, col, source.begin, source.end);
+  msg_line(source.start, col, source.begin, source.end, source.last);
   fprintf(stderr, "%*s | %*s", padding, "", base, "");
   msg_underline(source.end - source.begin);
-  vfprintf(stderr, format, args);
-  fputc('\n', stderr);
+  fprintf(stderr, "%s\n", message);
 }
 
-void fatal_at(source_t source, const char *format, ...)
+#ifdef Y_POSIX
+static pthread_mutex_t diag_lock = PTHREAD_MUTEX_INITIALIZER; // Guards yctx_t::diags
+#endif
+
+// Records a problem with the unit's input and lets the caller carry on past
+// it; a unit with any is dropped once parsed. `source.begin` is NULL for
+// problems with no place in the input.
+static void report(unit_t *unit, source_t source, y_error code, const char *format, ...)
 {
+  char message[256];
   va_list va;
 
-  fprintf(stderr, "liby " C_FATAL "fatal" C_RESET " %d:%d:\n", source.line, (int)(source.begin - source.start));
-  va_start(va, format);
-  msg(source, C_FATAL, format, va);
-  va_end(va);
+  source.line++; // Counted from 0 by the lexer
 
-  exit(1);
-}
+  // Units lexed from a bare string, as y_find's are, keep no line start.
+  if (!source.start)
+  {
+    for (source.start = source.begin; source.start > source.first && source.start[-1] != '\n'; )
+      source.start--;
+  }
 
-static char *raw(unit_t *unit)
-{
-  char *ch = (unit->data + unit->cursor++);
+  va_start(va, format);
+  vsnprintf(message, sizeof(message), format, va);
+  va_end(va);
 
-  if (*ch == '/' && *(ch + 1) == '/')
+  if (unit->verbose)
   {
-    *ch += 2;
+    fprintf(stderr, "liby " C_FATAL "error" C_RESET " %s:%d:%d:\n", unit->name ? unit->name : "", source.line, (int)(source.begin - source.start));
 
-    while (*ch && *ch != '\n')
-      ch = (unit->data + unit->cursor++);
+    if (source.begin)
+      msg(source, C_FATAL, message);
+    else
+      fprintf(stderr, "%s\n", message);
   }
 
-  return ch;
-}
+  // The message and file name share one block, freed through `message`
+  u64 length = strlen(message) + 1;
+  u64 name = unit->name ? strlen(unit->name) + 1 : 0;
+  char *text = allocate(NULL, length + name);
 
-static char *next(unit_t *unit)
-{
-  char *ch = raw(unit);
+  memcpy(text, message, length);
+
+  if (name)
+    memcpy(text + length, unit->name, name);
 
-  switch (*ch)
+  y_diag_t diag =
   {
-  case '\n':
-    unit->line++;
-    unit->start = ch + 1;
-    // fallthrough
-  case '\t':
-  case  ' ':
-    return next(unit);
-  }
+    .code    = code,
+    .file    = name ? text + length : NULL,
+    .message = text,
+    .line    = source.line,
+    .column  = source.begin - source.start,
+    .begin   = source.begin ? unit->base + (source.begin - source.first) : 0,
+    .end     = source.begin ? unit->base + (source.end - source.first) : 0,
+  };
 
-  return ch;
+  if (!unit->diags)
+    unit->diags = buf_create(0, sizeof(y_diag_t), NULL);
+
+  buf_push(unit->diags, &diag);
 }
 
-static source_t source(unit_t *unit, char *begin, char *end)
+static void diags_drop(buf_t *diags)
 {
-  return (source_t)
-  {
-    .line   = unit->line,
-    .start  = unit->start,
-    .begin  = begin,
-    .end    = end
-  };
+  if (!diags)
+    return;
+
+  for (u64 i = 0; i < diags->length; i++)
+    deallocate(NULL, (void *) ((y_diag_t *) buf_get(diags, i))->message);
+
+  buf_delete(diags);
 }
 
-static token_t token_new(unit_t *unit, token kind, char *begin, char *end)
+// Hands a unit's problems to the context, which readers entering lazy bodies
+// may be adding to at the same time.
+static void diags_move(yctx_t *y, unit_t *unit)
 {
-  token_t token;
+  if (!unit->diags)
+    return;
 
-  token.kind = kind;
-  token.source = source(unit, begin, end);
+#ifdef Y_POSIX
+  pthread_mutex_lock(&diag_lock);
+#endif
 
-  if (kind == TOKEN_TEXT || kind == TOKEN_STRING)
-  {
-    token.value.kind = Y_STRING;
-    token.value.string = (string_t) { .string = begin, .length = end - begin };
-  }
+  for (u64 i = 0; i < unit->diags->length; i++)
+    buf_push(y->diags, buf_get(unit->diags, i));
 
-  return token;
+#ifdef Y_POSIX
+  pthread_mutex_unlock(&diag_lock);
+#endif
+
+  buf_delete(unit->diags);
+  unit->diags = NULL;
 }
 
-static token_t token_string(unit_t *unit, char *begin)
+static const char *blank_scalar(unit_t *unit, const char *ch, const char *end)
 {
-  char *ch;
-
-  while (*(ch = raw(unit)) != '\"')
+  for (; ch < end; ch++)
   {
     if (*ch == '\n')
-      fatal_at(source(unit, ch, ch + 1), "Strings can not contain a new line.");
+    {
+      unit->line++;
+      unit->start = ch + 1;
+    }
+    else if (*ch != ' ' && *ch != '\t')
+      break;
   }
 
-  return token_new(unit, TOKEN_STRING, begin + 1, ch);
+  return ch;
 }
 
-static token_t token_text(unit_t *unit, char *begin)
+#ifdef Y_X86
+static const char *blank_lines(unit_t *unit, const char *ch, u32 lines)
 {
-  char *ch = begin;
-
-  while (isalpha(*ch) || isdigit(*ch) || *ch == '_')
-    ch = raw(unit);
+  if (lines)
+  {
+    unit->line += __builtin_popcount(lines);
+    unit->start = ch + (31 - __builtin_clz(lines)) + 1;
+  }
 
-  return token_new(unit, TOKEN_TEXT, begin, (unit->data + --unit->cursor));
+  return ch;
 }
 
-static token_t token_number(unit_t *unit, char *begin)
+// Skips whole 16 byte blocks of ' ', '\t' and '\n', stopping at the first
+// other byte or when less than a full block is left before `end`.
+static const char *blank_sse2(unit_t *unit, const char *ch, const char *end)
 {
-  token_t token;
-  y_kind  number = Y_INTEGER;
-  char *ch = begin;
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab   = _mm_set1_epi8('\t');
+  const __m128i lf    = _mm_set1_epi8('\n');
 
-  while (isdigit(*ch) || *ch == '_' || *ch == '.')
+  while (end - ch >= 16)
   {
-    ch = raw(unit);
+    __m128i block = _mm_loadu_si128((const __m128i *) ch);
+    __m128i line  = _mm_cmpeq_epi8(block, lf);
+    __m128i blank = _mm_or_si128(line, _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)));
+    u32 lines = (u32) _mm_movemask_epi8(line);
+    u32 other = ~(u32) _mm_movemask_epi8(blank) & 0xFFFF;
 
-    if (*ch == '.')
+    if (other)
     {
-      if (number == Y_DECIMAL)
-        fatal_at(source(unit, ch, ch + 1), "Duplicate floating-point decimal in number.");
+      u32 run = __builtin_ctz(other);
 
-      number = Y_DECIMAL;
+      blank_lines(unit, ch, lines & ((1u << run) - 1));
+      return ch + run;
     }
-  }
 
-  token = token_new(unit, TOKEN_NUMBER, begin, (unit->data + --unit->cursor));
-  token.value.kind = number;
-
-  if (number == Y_INTEGER)
-    token.value.integer = strtoull(token.source.begin, &token.source.end, 10);
-  else if (number == Y_DECIMAL)
-    token.value.decimal = strtod(token.source.begin, &token.source.end);
+    blank_lines(unit, ch, lines);
+    ch += 16;
+  }
 
-  return token;
+  return ch;
 }
 
-
-static token_t lex_token(unit_t *unit)
+__attribute__((target("avx2")))
+static const char *blank_avx2(unit_t *unit, const char *ch, const char *end)
 {
-  if (unit->cursor > unit->length)
-    return token_new(unit, TOKEN_NONE, 0, 0);
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab   = _mm256_set1_epi8('\t');
+  const __m256i lf    = _mm256_set1_epi8('\n');
 
-  char *ch = next(unit);
-
-  switch (*ch)
-  {
-  case 0: // EOF
-    return token_new(unit, TOKEN_NONE, ch, ch);
-  case '{': case '}': case '@':
-    return token_new(unit, *ch, ch, ch + 1);
-  case '\"':
-    return token_string(unit, ch);
-  default:
+  while (end - ch >= 32)
   {
-    if (isalpha(*ch) || *ch == '_')
-      return token_text(unit, ch);
+    __m256i block = _mm256_loadu_si256((const __m256i *) ch);
+    __m256i line  = _mm256_cmpeq_epi8(block, lf);
+    __m256i blank = _mm256_or_si256(line, _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)));
+    u32 lines = (u32) _mm256_movemask_epi8(line);
+    u32 other = ~(u32) _mm256_movemask_epi8(blank);
 
-    if (isdigit(*ch))
-      return token_number(unit, ch);
-  }
+    if (other)
+    {
+      u32 run = __builtin_ctz(other);
+
+      blank_lines(unit, ch, run < 32 ? lines & ((1u << run) - 1) : lines);
+      return ch + run;
+    }
+
+    blank_lines(unit, ch, lines);
+    ch += 32;
   }
 
-  fatal_at(source(unit, ch, ch + 1), "Unknown character: %c (%d)", *ch, *ch);
-  return (token_t) { 0 };
+  return blank_sse2(unit, ch, end);
 }
 
-static token_t lex_next(unit_t *unit)
+// Finds the first `"`, `\` or '\n' a block at a time, stopping early when
+// less than a full block is left before `end`.
+static const char *quote_sse2(const char *ch, const char *end)
 {
-  unit->previous = unit->current;
+  const __m128i quote = _mm_set1_epi8('\"');
+  const __m128i slash = _mm_set1_epi8('\\');
+  const __m128i lf    = _mm_set1_epi8('\n');
 
-  return (unit->current = lex_token(unit));
+  while (end - ch >= 16)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *) ch);
+    __m128i stops = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, slash));
+    u32 stop = (u32) _mm_movemask_epi8(_mm_or_si128(stops, _mm_cmpeq_epi8(block, lf)));
+
+    if (stop)
+      return ch + __builtin_ctz(stop);
+
+    ch += 16;
+  }
+
+  return ch;
 }
 
-token_t *token_eat(unit_t *unit)
+__attribute__((target("avx2")))
+static const char *quote_avx2(const char *ch, const char *end)
 {
-  lex_next(unit);
+  const __m256i quote = _mm256_set1_epi8('\"');
+  const __m256i slash = _mm256_set1_epi8('\\');
+  const __m256i lf    = _mm256_set1_epi8('\n');
 
-  return &unit->previous;
+  while (end - ch >= 32)
+  {
+    __m256i block = _mm256_loadu_si256((const __m256i *) ch);
+    __m256i stops = _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, slash));
+    u32 stop = (u32) _mm256_movemask_epi8(_mm256_or_si256(stops, _mm256_cmpeq_epi8(block, lf)));
+
+    if (stop)
+      return ch + __builtin_ctz(stop);
+
+    ch += 32;
+  }
+
+  return quote_sse2(ch, end);
 }
 
-token_t *token_expect(unit_t *unit, token kind)
+static const char *blank_resolve(unit_t *unit, const char *ch, const char *end);
+static const char *quote_resolve(const char *ch, const char *end);
+
+static const char *(*blank_vector)(unit_t *unit, const char *ch, const char *end) = blank_resolve;
+static const char *(*quote_vector)(const char *ch, const char *end) = quote_resolve;
+
+static void vector_resolve(void)
 {
-  if (unit->current.kind == kind)
-    return token_eat(unit);
+  __builtin_cpu_init();
 
-  fatal_at(unit->current.source, "Expected token: %d, Recieved token: %d", kind, unit->current.kind);
-  return NULL;
+  if (__builtin_cpu_supports("avx2"))
+  {
+    blank_vector = blank_avx2;
+    quote_vector = quote_avx2;
+  }
+  else
+  {
+    blank_vector = blank_sse2;
+    quote_vector = quote_sse2;
+  }
 }
 
-token_t *token_consume(unit_t *unit, token kind)
+static const char *blank_resolve(unit_t *unit, const char *ch, const char *end)
 {
-  if (unit->current.kind == kind)
-    return token_eat(unit);
+  vector_resolve();
+  return blank_vector(unit, ch, end);
+}
 
-  return NULL;
+static const char *quote_resolve(const char *ch, const char *end)
+{
+  vector_resolve();
+  return quote_vector(ch, end);
+}
+#else
+#define blank_vector blank_scalar
+#define quote_vector(ch, end) (ch)
+#endif
+
+// Moves a pointer into the old window, [from, until], to where its byte now
+// lives; pointers elsewhere, such as decoded strings, are left alone.
+static void rebase(const char **ptr, const char *from, const char *until, const char *keep, const char *to)
+{
+  if (*ptr >= from && *ptr <= until)
+    *ptr = *ptr < keep ? to : to + (*ptr - keep);
 }
 
-static y_note_t *parse_note(unit_t *unit)
+// Slides the unconsumed tail of a streamed window to the front and reads the
+// next chunk behind it. Everything from `*at` on survives, as does the
+// previous token, whose strings the parser has not copied out yet. While a
+// long token is read the tail is already at the front, so the window only
+// grows, doubling once it is half full.
+static bool unit_more(unit_t *unit, const char **at)
 {
-  y_note_t head = { 0 }, *it = &head;
+  if (!unit->read)
+    return false;
 
-  while (token_consume(unit, '@'))
+  token_t *previous = &unit->previous;
+  const char *keep = *at;
+
+  if (previous->source.begin && previous->source.begin < keep)
+    keep = previous->source.begin;
+
+  if (unit->start < keep && keep - unit->start < STREAM_WINDOW / 4)
+    keep = unit->start;
+
+  u64 offset = keep - unit->data;
+  u64 kept = unit->length - offset;
+  char *window = (char *) unit->data;
+
+  if (kept * 2 > unit->capacity)
   {
-    y_note_t *note = it = it->next = allocate(NULL, sizeof(y_note_t));
-    note->name = token_expect(unit, TOKEN_TEXT)->value.string;
+    unit->capacity *= 2;
+    window = reallocate(NULL, window, unit->capacity);
   }
 
-  return head.next;
+  if (offset)
+    memmove(window, window + offset, kept);
+
+  unit->base += offset;
+
+  const char *from  = unit->data;
+  const char *until = unit->data + unit->length;
+
+  keep = from + offset;
+
+  rebase(at, from, until, keep, window);
+  rebase(&unit->start, from, until, keep, window);
+  rebase(&previous->source.start, from, until, keep, window);
+  rebase(&previous->source.first, from, until, keep, window);
+  rebase(&previous->source.begin, from, until, keep, window);
+  rebase(&previous->source.end, from, until, keep, window);
+  rebase(&previous->source.last, from, until, keep, window);
+
+  if (previous->kind == TOKEN_TEXT || previous->kind == TOKEN_STRING)
+    rebase(&previous->value.string.string, from, until, keep, window);
+
+  u64 got = unit->read(unit->user, window + kept, unit->capacity - kept);
+
+  if (!got)
+    unit->read = NULL;
+
+  unit->data = window;
+  unit->length = kept + got;
+  unit->cursor = *at - window;
+
+  return got > 0;
 }
 
-static y_node_t *parse_node(unit_t *unit)
+// Steps over whitespace and `//` comments in one loop, leaving the cursor
+// just past the returned character, which is `end` once the input runs out.
+static const char *next(unit_t *unit)
 {
-  y_node_t *node = allocate(NULL, sizeof(y_node_t));
-  token_t *temp, *name = token_expect(unit, TOKEN_TEXT);
-
-  node->name = name->value.string;
+  const char *ch = unit->data + unit->cursor;
+  const char *end;
+  bool comment = false;
 
-  if (token_consume(unit, '{'))
+  for (;;)
   {
-    y_node_t head = { 0 }, *it = &head;
+    end = unit->data + unit->length;
+
+    if (comment)
+    {
+      const char *lf = memchr(ch, '\n', end - ch);
 
-    while (!token_consume(unit, '}'))
+      if (lf)
+      {
+        ch = lf;
+        comment = false;
+        continue;
+      }
+
+      ch = end;
+    }
+    else
     {
-      if (temp = token_consume(unit, TOKEN_NONE))
-        fatal_at(temp->source, "Expecting ending to node list.");
-      
-      it = it->next = parse_node(unit);
-      it->parent = node;
+      ch = blank_scalar(unit, blank_vector(unit, ch, end), end);
+
+      if (end - ch >= 2 && ch[0] == '/' && ch[1] == '/')
+      {
+        comment = true;
+        continue;
+      }
+
+      // A lone `/` at the end of a streamed chunk may still open a comment.
+      if (end - ch >= 2 || (ch < end && *ch != '/'))
+        break;
     }
 
-    node->value.kind = Y_NODE;
-    node->value.node = head.next;
-  }
-  else if (temp = token_consume(unit, TOKEN_NUMBER)) 
-  {
-    node->value = temp->value;
-  }
-  else if (temp = token_consume(unit, TOKEN_STRING))
-  {
-    node->value = temp->value;
+    if (!unit_more(unit, &ch))
+      break;
   }
 
-  node->note = parse_note(unit);
-
-  return node;
+  end = unit->data + unit->length;
+  unit->cursor = ch - unit->data + (ch < end);
+  return ch;
 }
 
-static y_node_t *parse_unit(unit_t *unit)
+static source_t source(unit_t *unit, const char *begin, const char *end)
 {
-  y_node_t *node = parse_node(unit);
-  token_expect(unit, TOKEN_NONE);
-
-  return node;
+  return (source_t)
+  {
+    .line   = unit->line,
+    .start  = unit->start,
+    .begin  = begin,
+    .end    = end,
+    .first  = unit->data,
+    .last   = unit->data + unit->length
+  };
 }
 
-yctx_t y_create(void)
+static token_t token_new(unit_t *unit, token kind, const char *begin, const char *end)
 {
-  yctx_t ctx = { 0 };
+  token_t token;
 
-  ctx.heads = &ctx.root;
-  ctx.units = buf_create(0, sizeof(unit_t), NULL);
-  
-  return ctx;
+  token.kind = kind;
+  token.source = source(unit, begin, end);
+
+  if (kind == TOKEN_TEXT || kind == TOKEN_STRING)
+  {
+    token.value.kind = Y_STRING;
+    token.value.string = (string_t) { .string = begin, .length = end - begin };
+  }
+
+  return token;
 }
 
-void y_delete(yctx_t *y)
+static int hex(const char *ch)
 {
-  buf_delete(y->units);
+  int value = 0;
+
+  for (int i = 0; i < 4; i++)
+  {
+    int digit = ch[i] >= '0' && ch[i] <= '9' ? ch[i] - '0'
+              : (ch[i] | 0x20) >= 'a' && (ch[i] | 0x20) <= 'f' ? (ch[i] | 0x20) - 'a' + 10 : -1;
+
+    if (digit < 0)
+      return -1;
+
+    value = value * 16 + digit;
+  }
+
+  return value;
 }
 
-y_node_t *y_load(yctx_t *y, cstr path)
+// Decodes `\uXXXX`, or a surrogate pair of them, at `ch` into UTF-8.
+static const char *escape_unicode(unit_t *unit, const char *ch, const char *end, char **out)
 {
-  unit_t unit = { 0 };
-  fs_item_t *file = fs_open(path);
+  long code = end - ch >= 6 ? hex(ch + 2) : -1;
+  const char *last = ch + 6;
 
-  assert(file->kind == FS_FILE);
+  if (code >= 0xD800 && code <= 0xDBFF)
+  {
+    long low = end - last >= 6 && last[0] == '\\' && last[1] == 'u' ? hex(last + 2) : -1;
 
-  unit.length = fs_read(file, &unit.data, 0);
-  unit.start = unit.data;
-  fs_close(file);
+    code = low >= 0xDC00 && low <= 0xDFFF ? 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00) : -1;
+    last += 6;
+  }
+  else if (code >= 0xDC00 && code <= 0xDFFF)
+    code = -1;
 
-  lex_next(&unit);
-  y_node_t *head = parse_unit(&unit);
-  y->heads = y->heads->next = head;
+  if (last > end)
+    last = end;
 
-  buf_push(y->units, &unit);
+  // Dropped from the string, which is only kept for the report anyway
+  if (code < 0)
+  {
+    report(unit, source(unit, ch, last), Y_ERROR_ESCAPE, "Invalid unicode escape.");
+    return last;
+  }
 
-  return head;
+  char *it = *out;
+
+  if (code < 0x80)
+    *it++ = code;
+  else if (code < 0x800)
+  {
+    *it++ = 0xC0 | (code >> 6);
+    *it++ = 0x80 | (code & 0x3F);
+  }
+  else if (code < 0x10000)
+  {
+    *it++ = 0xE0 | (code >> 12);
+    *it++ = 0x80 | ((code >> 6) & 0x3F);
+    *it++ = 0x80 | (code & 0x3F);
+  }
+  else
+  {
+    *it++ = 0xF0 | (code >> 18);
+    *it++ = 0x80 | ((code >> 12) & 0x3F);
+    *it++ = 0x80 | ((code >> 6) & 0x3F);
+    *it++ = 0x80 | (code & 0x3F);
+  }
+
+  *out = it;
+  return last;
 }
 
-y_node_t *y_find(yctx_t *y, cstr path)
+// Only strings that contain a `\` are decoded; the copy goes to the unit's
+// arena and is never longer than the escaped text.
+static string_t string_decode(unit_t *unit, const char *begin, const char *end)
 {
-  unit_t unit = { .data = (char *) path, .length = strlen(path) };
-  y_node_t *current = y->heads;
-  token_t *temp;
-  bool found = false;
+  char *copy = arena_push(&unit->arena, end - begin), *out = copy;
+  const char *ch = begin;
 
-  lex_next(&unit);
-  while ((temp = token_consume(&unit, TOKEN_TEXT)))
+  while (ch < end)
   {
-    // Looking for temp->value.string.string
-    for (y_node_t *it = current; it; it = it->next)
-    {
-      // Testing temp->value.string.string vs it->name.string
-      if (temp->value.string.length == it->name.length && !strncmp(temp->value.string.string, it->name.string, it->name.length))
-      {
-        if (unit.current.kind == TOKEN_NONE)
-          return it;
+    const char *slash = memchr(ch, '\\', end - ch);
+    const char *stop  = slash ? slash : end;
 
-        current = it->value.node;
-        found = true;
-        break;
-      }
-    }
+    memcpy(out, ch, stop - ch);
+    out += stop - ch;
+    ch = stop;
+
+    if (!slash)
+      break;
 
-    if (!found)
+    switch (ch[1])
     {
-      // Did not find a valid temp->value.string.string
-      return NULL;
+    case '\"':  *out++ = '\"';  ch += 2; break;
+    case '\\': *out++ = '\\'; ch += 2; break;
+    case 'n':  *out++ = '\n'; ch += 2; break;
+    case 't':  *out++ = '\t'; ch += 2; break;
+    case 'u':  ch = escape_unicode(unit, ch, end, &out); break;
+    default:
+      report(unit, source(unit, ch, ch + 2), Y_ERROR_ESCAPE, "Unknown escape sequence: \\%c", ch[1]);
+      *out++ = ch[1];
+      ch += 2;
     }
-
-    found = false;
   }
-}
 
-y_node_t *y_iter(y_node_t *begin, y_node_t **iter)
-{
-  if (*iter == NULL)
-    *iter = begin;
-
-  if ((*iter)->next == NULL)
-    return NULL;
-  
-  return (*iter = (*iter)->next);
+  return (string_t) { .string = copy, .length = out - copy };
 }
 
-y_note_t *y_has(y_node_t *node, string_t note)
+static token_t token_string(unit_t *unit, const char *begin)
 {
-  for (y_note_t *it = node->note; it; it = it->next)
+  const char *end = unit->data + unit->length;
+  const char *ch  = begin + 1;
+  bool escaped = false;
+  token_t token;
+
+  for (;;)
   {
-    if (it->name.length == note.length && !strncmp(it->name.string, note.string, note.length))
-      return it;
+    ch = quote_vector(ch, end);
+
+    while (ch < end && *ch != '\"' && *ch != '\n' && *ch != '\\')
+      ch++;
+
+    if (ch == end || *ch != '\\')
+      break;
+
+    // Step over the escaped character so `\"` does not end the string.
+    escaped = true;
+    ch += ch + 1 < end && ch[1] != '\n' ? 2 : 1;
+  }
+
+  if (ch == end && unit->read)
+    return token_new(unit, TOKEN_STRING, begin + 1, end);
+
+  // A broken string ends where the line or input does, undecoded
+  if (ch < end && *ch == '\n')
+  {
+    report(unit, source(unit, ch, ch + 1), Y_ERROR_STRING, "Strings can not contain a new line.");
+    escaped = false;
+  }
+  else if (ch == end)
+  {
+    report(unit, source(unit, begin, ch), Y_ERROR_STRING, "Unterminated string.");
+    escaped = false;
+  }
+
+  unit->cursor = ch + (ch < end && *ch == '\"') - unit->data;
+
+  token = token_new(unit, TOKEN_STRING, begin + 1, ch);
+
+  if (escaped)
+    token.value.string = string_decode(unit, begin + 1, ch);
+
+  return token;
+}
+
+static token_t token_text(unit_t *unit, const char *begin)
+{
+  const char *ch  = begin + 1;
+  const char *end = unit->data + unit->length;
+
+  while (ch < end && is(*ch, CLASS_IDENT))
+    ch++;
+
+  unit->cursor = ch - unit->data;
+  return token_new(unit, TOKEN_TEXT, begin, ch);
+}
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// True when all 8 bytes of `chunk` are ASCII digits.
+static bool swar_digits(u64 chunk)
+{
+  return ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// Converts 8 ASCII digits, first digit in the lowest byte, to their value.
+static u64 swar_value(u64 chunk)
+{
+  chunk -= 0x3030303030303030;
+  chunk  = (chunk * 10) + (chunk >> 8);
+  chunk  = (((chunk & 0x000000FF000000FF) * (100 + (1000000ULL << 32)))
+         + (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+
+  return chunk;
+}
+#endif
+
+// Reads a run of digits and `_` separators into `value` in one pass. Always
+// consumes the whole run; returns false if the value does not fit in a u64.
+static bool scan_integer(const char **at, const char *end, u64 *value)
+{
+  const char *ch = *at;
+  bool fits = true;
+  u64 result = 0;
+
+  while (ch < end)
+  {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    u64 chunk;
+
+    if (end - ch >= 8 && (memcpy(&chunk, ch, 8), swar_digits(chunk)))
+    {
+      fits &= !__builtin_mul_overflow(result, 100000000, &result);
+      fits &= !__builtin_add_overflow(result, swar_value(chunk), &result);
+      ch += 8;
+      continue;
+    }
+#endif
+
+    if (is(*ch, CLASS_DIGIT))
+    {
+      fits &= !__builtin_mul_overflow(result, 10, &result);
+      fits &= !__builtin_add_overflow(result, (u64) (*ch - '0'), &result);
+    }
+    else if (*ch != '_')
+      break;
+
+    ch++;
+  }
+
+  *at = ch;
+  *value = result;
+
+  return fits;
+}
+
+#define POW5_MIN -64
+#define POW5_MAX  32
+
+// 5^q normalised to 128 bits (high, low) for Eisel-Lemire; negative powers
+// are rounded up, as in fast_float.
+static const u64 pow5[POW5_MAX - POW5_MIN + 1][2] =
+{
+  { 0xA87FEA27A539E9A5, 0x3F2398D747B36224 }, // 5^-64
+  { 0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAD }, // 5^-63
+  { 0x83A3EEEEF9153E89, 0x1953CF68300424AC }, // 5^-62
+  { 0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD7 }, // 5^-61
+  { 0xCDB02555653131B6, 0x3792F412CB06794D }, // 5^-60
+  { 0x808E17555F3EBF11, 0xE2BBD88BBEE40BD0 }, // 5^-59
+  { 0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC4 }, // 5^-58
+  { 0xC8DE047564D20A8B, 0xF245825A5A445275 }, // 5^-57
+  { 0xFB158592BE068D2E, 0xEED6E2F0F0D56712 }, // 5^-56
+  { 0x9CED737BB6C4183D, 0x55464DD69685606B }, // 5^-55
+  { 0xC428D05AA4751E4C, 0xAA97E14C3C26B886 }, // 5^-54
+  { 0xF53304714D9265DF, 0xD53DD99F4B3066A8 }, // 5^-53
+  { 0x993FE2C6D07B7FAB, 0xE546A8038EFE4029 }, // 5^-52
+  { 0xBF8FDB78849A5F96, 0xDE98520472BDD033 }, // 5^-51
+  { 0xEF73D256A5C0F77C, 0x963E66858F6D4440 }, // 5^-50
+  { 0x95A8637627989AAD, 0xDDE7001379A44AA8 }, // 5^-49
+  { 0xBB127C53B17EC159, 0x5560C018580D5D52 }, // 5^-48
+  { 0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A6 }, // 5^-47
+  { 0x9226712162AB070D, 0xCAB3961304CA70E8 }, // 5^-46
+  { 0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D22 }, // 5^-45
+  { 0xE45C10C42A2B3B05, 0x8CB89A7DB77C506A }, // 5^-44
+  { 0x8EB98A7A9A5B04E3, 0x77F3608E92ADB242 }, // 5^-43
+  { 0xB267ED1940F1C61C, 0x55F038B237591ED3 }, // 5^-42
+  { 0xDF01E85F912E37A3, 0x6B6C46DEC52F6688 }, // 5^-41
+  { 0x8B61313BBABCE2C6, 0x2323AC4B3B3DA015 }, // 5^-40
+  { 0xAE397D8AA96C1B77, 0xABEC975E0A0D081A }, // 5^-39
+  { 0xD9C7DCED53C72255, 0x96E7BD358C904A21 }, // 5^-38
+  { 0x881CEA14545C7575, 0x7E50D64177DA2E54 }, // 5^-37
+  { 0xAA242499697392D2, 0xDDE50BD1D5D0B9E9 }, // 5^-36
+  { 0xD4AD2DBFC3D07787, 0x955E4EC64B44E864 }, // 5^-35
+  { 0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113E }, // 5^-34
+  { 0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58E }, // 5^-33
+  { 0xCFB11EAD453994BA, 0x67DE18EDA5814AF2 }, // 5^-32
+  { 0x81CEB32C4B43FCF4, 0x80EACF948770CED7 }, // 5^-31
+  { 0xA2425FF75E14FC31, 0xA1258379A94D028D }, // 5^-30
+  { 0xCAD2F7F5359A3B3E, 0x096EE45813A04330 }, // 5^-29
+  { 0xFD87B5F28300CA0D, 0x8BCA9D6E188853FC }, // 5^-28
+  { 0x9E74D1B791E07E48, 0x775EA264CF55347E }, // 5^-27
+  { 0xC612062576589DDA, 0x95364AFE032A819E }, // 5^-26
+  { 0xF79687AED3EEC551, 0x3A83DDBD83F52205 }, // 5^-25
+  { 0x9ABE14CD44753B52, 0xC4926A9672793543 }, // 5^-24
+  { 0xC16D9A0095928A27, 0x75B7053C0F178294 }, // 5^-23
+  { 0xF1C90080BAF72CB1, 0x5324C68B12DD6339 }, // 5^-22
+  { 0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04 }, // 5^-21
+  { 0xBCE5086492111AEA, 0x88F4BB1CA6BCF585 }, // 5^-20
+  { 0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6 }, // 5^-19
+  { 0x9392EE8E921D5D07, 0x3AFF322E62439FD0 }, // 5^-18
+  { 0xB877AA3236A4B449, 0x09BEFEB9FAD487C3 }, // 5^-17
+  { 0xE69594BEC44DE15B, 0x4C2EBE687989A9B4 }, // 5^-16
+  { 0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11 }, // 5^-15
+  { 0xB424DC35095CD80F, 0x538484C19EF38C95 }, // 5^-14
+  { 0xE12E13424BB40E13, 0x2865A5F206B06FBA }, // 5^-13
+  { 0x8CBCCC096F5088CB, 0xF93F87B7442E45D4 }, // 5^-12
+  { 0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749 }, // 5^-11
+  { 0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C }, // 5^-10
+  { 0x89705F4136B4A597, 0x31680A88F8953031 }, // 5^-9
+  { 0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E }, // 5^-8
+  { 0xD6BF94D5E57A42BC, 0x3D32907604691B4D }, // 5^-7
+  { 0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110 }, // 5^-6
+  { 0xA7C5AC471B478423, 0x0FCF80DC33721D54 }, // 5^-5
+  { 0xD1B71758E219652B, 0xD3C36113404EA4A9 }, // 5^-4
+  { 0x83126E978D4FDF3B, 0x645A1CAC083126EA }, // 5^-3
+  { 0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4 }, // 5^-2
+  { 0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD }, // 5^-1
+  { 0x8000000000000000, 0x0000000000000000 }, // 5^0
+  { 0xA000000000000000, 0x0000000000000000 }, // 5^1
+  { 0xC800000000000000, 0x0000000000000000 }, // 5^2
+  { 0xFA00000000000000, 0x0000000000000000 }, // 5^3
+  { 0x9C40000000000000, 0x0000000000000000 }, // 5^4
+  { 0xC350000000000000, 0x0000000000000000 }, // 5^5
+  { 0xF424000000000000, 0x0000000000000000 }, // 5^6
+  { 0x9896800000000000, 0x0000000000000000 }, // 5^7
+  { 0xBEBC200000000000, 0x0000000000000000 }, // 5^8
+  { 0xEE6B280000000000, 0x0000000000000000 }, // 5^9
+  { 0x9502F90000000000, 0x0000000000000000 }, // 5^10
+  { 0xBA43B74000000000, 0x0000000000000000 }, // 5^11
+  { 0xE8D4A51000000000, 0x0000000000000000 }, // 5^12
+  { 0x9184E72A00000000, 0x0000000000000000 }, // 5^13
+  { 0xB5E620F480000000, 0x0000000000000000 }, // 5^14
+  { 0xE35FA931A0000000, 0x0000000000000000 }, // 5^15
+  { 0x8E1BC9BF04000000, 0x0000000000000000 }, // 5^16
+  { 0xB1A2BC2EC5000000, 0x0000000000000000 }, // 5^17
+  { 0xDE0B6B3A76400000, 0x0000000000000000 }, // 5^18
+  { 0x8AC7230489E80000, 0x0000000000000000 }, // 5^19
+  { 0xAD78EBC5AC620000, 0x0000000000000000 }, // 5^20
+  { 0xD8D726B7177A8000, 0x0000000000000000 }, // 5^21
+  { 0x878678326EAC9000, 0x0000000000000000 }, // 5^22
+  { 0xA968163F0A57B400, 0x0000000000000000 }, // 5^23
+  { 0xD3C21BCECCEDA100, 0x0000000000000000 }, // 5^24
+  { 0x84595161401484A0, 0x0000000000000000 }, // 5^25
+  { 0xA56FA5B99019A5C8, 0x0000000000000000 }, // 5^26
+  { 0xCECB8F27F4200F3A, 0x0000000000000000 }, // 5^27
+  { 0x813F3978F8940984, 0x4000000000000000 }, // 5^28
+  { 0xA18F07D736B90BE5, 0x5000000000000000 }, // 5^29
+  { 0xC9F2C9CD04674EDE, 0xA400000000000000 }, // 5^30
+  { 0xFC6F7C4045812296, 0x4D00000000000000 }, // 5^31
+  { 0x9DC5ADA82B70B59D, 0xF020000000000000 }, // 5^32
+};
+
+static const f64 pow10[] =
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// The high half of a * b, and the low half in `low`; from 32 bit halves
+// where the compiler has no 128 bit integers, as on 32 bit targets.
+static u64 multiply_high(u64 a, u64 b, u64 *low)
+{
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 product = (unsigned __int128) a * b;
+
+  *low = (u64) product;
+  return (u64) (product >> 64);
+#else
+  u64 al = (u32) a, ah = a >> 32, bl = (u32) b, bh = b >> 32;
+  u64 ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+  u64 middle = (ll >> 32) + (u32) lh + (u32) hl;
+
+  *low = (middle << 32) | (u32) ll;
+  return hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+#endif
+}
+
+// Eisel-Lemire: w * 10^q rounded to the nearest f64, for normalised results
+// only. `w` must be non-zero and `q` inside the pow5 table.
+static f64 decimal_lemire(u64 w, int q)
+{
+  int lz = __builtin_clzll(w);
+  const u64 *power = pow5[q - POW5_MIN];
+  u64 low, unused;
+  u64 high = multiply_high(w << lz, power[0], &low);
+
+  if ((high & 0x1FF) == 0x1FF)
+  {
+    u64 second = multiply_high(w << lz, power[1], &unused);
+
+    low += second;
+    high += second > low;
+  }
+
+  int upper = (int) (high >> 63);
+  int shift = upper + 9;
+  u64 mantissa = high >> shift;
+  i64 power2 = (((152170 + 65536) * q) >> 16) + 63 + upper - lz + 1023;
+
+  if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high)
+    mantissa &= ~(u64) 1;
+
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+
+  if (mantissa >= (2ULL << 52))
+  {
+    mantissa = 1ULL << 52;
+    power2++;
+  }
+
+  u64 bits = (mantissa & ~(1ULL << 52)) | ((u64) power2 << 52);
+  f64 value;
+
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Hard cases: strtod in the "C" locale over a copy without `_` separators.
+// Without POSIX locales it is plain strtod, in whatever locale is current.
+static f64 decimal_slow(const char *begin, const char *end)
+{
+  char stack[128], *copy = stack, *it;
+  f64 value;
+
+#ifdef Y_POSIX
+  static locale_t c_locale;
+  locale_t locale = __atomic_load_n(&c_locale, __ATOMIC_ACQUIRE);
+
+  if (!locale)
+  {
+    locale_t expected = NULL;
+
+    locale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+
+    if (!__atomic_compare_exchange_n(&c_locale, &expected, locale, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+      freelocale(locale);
+      locale = expected;
+    }
+  }
+#endif
+
+  if (end - begin >= (long) sizeof(stack))
+    copy = allocate(NULL, end - begin + 1);
+
+  for (it = copy; begin < end; begin++)
+  {
+    if (*begin != '_')
+      *it++ = *begin;
+  }
+
+  *it = 0;
+
+#ifdef Y_POSIX
+  value = strtod_l(copy, NULL, locale);
+#else
+  value = strtod(copy, NULL);
+#endif
+
+  if (copy != stack)
+    deallocate(NULL, copy);
+
+  return value;
+}
+
+// Converts a literal made of digits, `_` separators and one `.` to the
+// correctly rounded f64, independent of the current locale.
+static f64 decimal_value(const char *begin, const char *end)
+{
+  u64 w = 0;
+  int digits = 0, q = 0;
+  bool fraction = false, truncated = false;
+
+  for (const char *ch = begin; ch < end; ch++)
+  {
+    if (*ch == '.')
+      fraction = true;
+    else if (*ch == '_' || (*ch == '0' && !digits && !fraction))
+      continue;
+    else if (digits < 19 && (digits || *ch != '0'))
+    {
+      w = w * 10 + (u64) (*ch - '0');
+      digits++;
+      q -= fraction;
+    }
+    else if (digits < 19)
+      q--;
+    else
+    {
+      truncated |= *ch != '0';
+      q += !fraction;
+    }
+  }
+
+  if (!w)
+    return 0.0;
+
+  if (!truncated && q >= -22 && w <= (1ULL << 53))
+    return (f64) w / pow10[-q];
+
+  if (q >= POW5_MIN && q <= POW5_MAX)
+  {
+    f64 value = decimal_lemire(w, q);
+
+    if (!truncated || value == decimal_lemire(w + 1, q))
+      return value;
+  }
+
+  return decimal_slow(begin, end);
+}
+
+static token_t token_number(unit_t *unit, const char *begin)
+{
+  token_t token;
+  const char *ch  = begin;
+  const char *end = unit->data + unit->length;
+  const char *dot = NULL;
+  bool fits = scan_integer(&ch, end, &token.value.integer);
+
+  token.value.kind = Y_INTEGER;
+
+  if (ch < end && *ch == '.')
+  {
+    for (ch++; ch < end && is(*ch, CLASS_NUMBER); ch++)
+    {
+      if (*ch == '.' && !dot)
+        dot = ch;
+    }
+
+    token.value.kind = Y_DECIMAL;
+    token.value.decimal = decimal_value(begin, dot ? dot : ch);
+  }
+
+  unit->cursor = ch - unit->data;
+  token.kind = TOKEN_NUMBER;
+  token.source = source(unit, begin, ch);
+
+  // A number cut off by the end of a streamed chunk is lexed again
+  if (ch == end && unit->read)
+    return token;
+
+  if (dot)
+    report(unit, source(unit, dot, dot + 1), Y_ERROR_NUMBER, "Duplicate floating-point decimal in number.");
+  else if (token.value.kind == Y_INTEGER && !fits)
+    report(unit, token.source, Y_ERROR_NUMBER, "Integer does not fit in 64 bits.");
+
+  return token;
+}
+
+static token_t token_struct(unit_t *unit, const char *ch)
+{
+  return token_new(unit, *ch, ch, ch + 1);
+}
+
+static token_t token_end(unit_t *unit, const char *ch)
+{
+  return token_new(unit, TOKEN_NONE, ch, ch);
+}
+
+static token_t (*const lexers[256])(unit_t *unit, const char *ch) =
+{
+  ['{']         = token_struct,
+  ['}']         = token_struct,
+  ['[']         = token_struct,
+  [']']         = token_struct,
+  [',']         = token_struct,
+  ['@']         = token_struct,
+  ['\"']        = token_string,
+  ['a' ... 'z'] = token_text,
+  ['A' ... 'Z'] = token_text,
+  ['_']         = token_text,
+  ['0' ... '9'] = token_number,
+};
+
+// Reads on until the token at `*at`, cut off by the end of a streamed chunk,
+// ends inside the window or the input runs out. Each byte is scanned once as
+// it arrives, with the escape a chunk may end in carried over, so that the
+// lexer only goes over a token once it is whole.
+static void token_reach(unit_t *unit, const char **at)
+{
+  bool quoted = **at == '\"', slash = false;
+  u8 mask = is(**at, CLASS_DIGIT) ? CLASS_NUMBER : is(**at, CLASS_START) ? CLASS_IDENT : 0;
+  u64 offset = 1;
+
+  for (;;)
+  {
+    const char *ch  = *at + offset;
+    const char *end = unit->data + unit->length;
+
+    while (quoted && ch < end)
+    {
+      if (slash)
+      {
+        slash = false;
+
+        if (*ch == '\n')
+          break;
+
+        ch++;
+        continue;
+      }
+
+      ch = quote_vector(ch, end);
+
+      while (ch < end && *ch != '\"' && *ch != '\n' && *ch != '\\')
+        ch++;
+
+      if (ch == end || *ch != '\\')
+        break;
+
+      slash = true;
+      ch++;
+    }
+
+    while (!quoted && ch < end && is(*ch, mask))
+      ch++;
+
+    offset = ch - *at;
+
+    if (ch < end || !unit_more(unit, at))
+      return;
+  }
+}
+
+static token_t lex_token(unit_t *unit)
+{
+  for (;;)
+  {
+    const char *ch  = next(unit);
+    const char *end = unit->data + unit->length;
+    token_t token;
+
+    if (ch == end)
+      return token_end(unit, ch);
+
+    // Skipped, as if it were a blank; next() has stepped over it
+    if (!lexers[(u8) *ch])
+    {
+      report(unit, source(unit, ch, ch + 1), Y_ERROR_CHARACTER, "Unknown character: %c (%d)", *ch, *ch);
+      continue;
+    }
+
+    token = lexers[(u8) *ch](unit, ch);
+
+    // A token running into the end of a streamed chunk may continue in the
+    // next ones, so it is lexed again once all of it has arrived.
+    if (token.source.end != end || !unit->read)
+      return token;
+
+    token_reach(unit, &ch);
+  }
+}
+
+static token_t lex_next(unit_t *unit)
+{
+  unit->previous = unit->current;
+
+  return (unit->current = lex_token(unit));
+}
+
+token_t *token_eat(unit_t *unit)
+{
+  lex_next(unit);
+
+  return &unit->previous;
+}
+
+token_t *token_expect(unit_t *unit, token kind)
+{
+  if (unit->current.kind == kind)
+    return token_eat(unit);
+
+  report(unit, unit->current.source, Y_ERROR_SYNTAX, "Expected token: %d, Recieved token: %d", kind, unit->current.kind);
+  return NULL;
+}
+
+token_t *token_consume(unit_t *unit, token kind)
+{
+  if (unit->current.kind == kind)
+    return token_eat(unit);
+
+  return NULL;
+}
+
+// Eight bytes a round; most names take one or two. The last multiply only
+// carries the later bytes of a round up, so the high half is folded back down
+// for tables that index by the low bits.
+static u64 hash_name(const char *name, u64 length)
+{
+  u64 hash = length * 0x9e3779b97f4a7c15;
+
+  for (;;)
+  {
+    u64 word = 0;
+
+    if (length >= 8)
+      memcpy(&word, name, 8);
+    else
+    {
+      for (u64 i = 0; i < length; i++)
+        word |= (u64) (u8) name[i] << (i * 8);
+    }
+
+    hash = (hash ^ word) * 0xbf58476d1ce4e5b9;
+    hash ^= hash >> 31;
+
+    if (length <= 8)
+    {
+      hash *= 0x94d049bb133111eb;
+      return hash ^ (hash >> 32);
+    }
+
+    name += 8;
+    length -= 8;
+  }
+}
+
+#define ATOMS_MIN 1024 // Slots of the first table of atoms
+#define HELD_MIN  64   // Slots of the first set of atoms a unit holds
+
+// A name or note as interned: numbered from 1, in whichever order parsers got
+// to it, and kept NUL-terminated for as long as a unit loaded holds it.
+typedef struct atom_t
+{
+  u64 hash;
+  struct y_atoms_t *atoms; // The table it is in, for y_has
+  u32 id;
+  u32 length;
+  u32 units; // Units holding it; the last one dropped frees it
+  char name[];
+} atom_t;
+
+// Every name and note in the tree points into its atom, so two are the same
+// name when they are the same pointer. Only for names that are, which is why
+// the API hands out atoms by node and note rather than by string.
+static const atom_t *atom_of(string_t name)
+{
+  return (const atom_t *) (name.string - offsetof(atom_t, name));
+}
+
+// The hash sits next to its atom, so probing and growing only touch the atoms
+// they are after.
+typedef struct atoms_slot_t
+{
+  atom_t *atom;
+  u64 hash;
+} atoms_slot_t;
+
+// Open addressing, never more than half full. Growing makes a table twice the
+// size; the smaller one stays for readers that may still be probing it.
+typedef struct atoms_table_t
+{
+  struct atoms_table_t *smaller;
+  u64 mask;
+  atoms_slot_t slots[];
+} atoms_table_t;
+
+// Read without a lock: slots are only ever set once, the hash before the atom,
+// which is complete by then, and a grown table is complete before it replaces
+// the old one. Writers take the lock. Atoms are only taken out by dropping
+// units, which loads and y_unload do while no one reads.
+struct y_atoms_t
+{
+  atoms_table_t *table;
+  u64 count; // Atoms in the table
+  u32 last;  // Id of the newest atom
+
+#ifdef Y_POSIX
+  pthread_mutex_t lock;
+#endif
+};
+
+static y_atoms_t *atoms_create(void)
+{
+  y_atoms_t *atoms = allocate(NULL, sizeof(y_atoms_t));
+
+  *atoms = (y_atoms_t) { 0 };
+
+#ifdef Y_POSIX
+  pthread_mutex_init(&atoms->lock, NULL);
+#endif
+
+  return atoms;
+}
+
+// The units dropped before this have taken their atoms out already.
+static void atoms_delete(y_atoms_t *atoms)
+{
+  for (u64 i = 0; atoms->table && i <= atoms->table->mask; i++)
+  {
+    if (atoms->table->slots[i].atom)
+      deallocate(NULL, atoms->table->slots[i].atom);
+  }
+
+  for (atoms_table_t *it = atoms->table, *smaller; it; it = smaller)
+  {
+    smaller = it->smaller;
+    deallocate(NULL, it);
+  }
+
+#ifdef Y_POSIX
+  pthread_mutex_destroy(&atoms->lock);
+#endif
+
+  deallocate(NULL, atoms);
+}
+
+static void atoms_lock(y_atoms_t *atoms)
+{
+#ifdef Y_POSIX
+  pthread_mutex_lock(&atoms->lock);
+#else
+  (void) atoms;
+#endif
+}
+
+static void atoms_unlock(y_atoms_t *atoms)
+{
+#ifdef Y_POSIX
+  pthread_mutex_unlock(&atoms->lock);
+#else
+  (void) atoms;
+#endif
+}
+
+static atom_t *atoms_find(y_atoms_t *atoms, u64 hash, const char *name, u64 length)
+{
+  atoms_table_t *table = __atomic_load_n(&atoms->table, __ATOMIC_ACQUIRE);
+
+  if (!table)
+    return NULL;
+
+  for (u64 slot = hash & table->mask;; slot = (slot + 1) & table->mask)
+  {
+    atom_t *atom = __atomic_load_n(&table->slots[slot].atom, __ATOMIC_ACQUIRE);
+
+    if (!atom)
+      return NULL;
+
+    if (__atomic_load_n(&table->slots[slot].hash, __ATOMIC_RELAXED) == hash && atom->length == length && !memcmp(atom->name, name, length))
+      return atom;
+  }
+}
+
+static void atoms_place(atoms_table_t *table, atom_t *atom, u64 hash)
+{
+  u64 slot = hash & table->mask;
+
+  while (table->slots[slot].atom)
+    slot = (slot + 1) & table->mask;
+
+  __atomic_store_n(&table->slots[slot].hash, hash, __ATOMIC_RELAXED);
+  __atomic_store_n(&table->slots[slot].atom, atom, __ATOMIC_RELEASE);
+}
+
+static void atoms_grow(y_atoms_t *atoms)
+{
+  atoms_table_t *smaller = atoms->table;
+  u64 capacity = smaller ? (smaller->mask + 1) * 2 : ATOMS_MIN;
+  atoms_table_t *table = allocate(NULL, sizeof(atoms_table_t) + capacity * sizeof(atoms_slot_t));
+
+  memset(table->slots, 0, capacity * sizeof(atoms_slot_t));
+  table->smaller = smaller;
+  table->mask = capacity - 1;
+
+  for (u64 i = 0; smaller && i <= smaller->mask; i++)
+  {
+    if (smaller->slots[i].atom)
+      atoms_place(table, smaller->slots[i].atom, smaller->slots[i].hash);
+  }
+
+  __atomic_store_n(&atoms->table, table, __ATOMIC_RELEASE);
+}
+
+// Only called with the lock held.
+static atom_t *atoms_intern(y_atoms_t *atoms, u64 hash, const char *name, u64 length)
+{
+  atom_t *atom = atoms_find(atoms, hash, name, length);
+
+  if (atom)
+    return atom;
+
+  if (!atoms->table || (u64) (atoms->count + 1) * 2 > atoms->table->mask + 1)
+    atoms_grow(atoms);
+
+  atom = allocate(NULL, sizeof(atom_t) + length + 1);
+  atom->hash = hash;
+  atom->atoms = atoms;
+  atom->id = ++atoms->last;
+  atom->length = length;
+  atom->units = 0;
+
+  memcpy(atom->name, name, length);
+  atom->name[length] = '\0';
+
+  atoms_place(atoms->table, atom, hash);
+  atoms->count++;
+
+  return atom;
+}
+
+// Takes out an atom no unit holds any more, shifting back the ones after it
+// that probed past its slot. Only while no one reads the table, which is also
+// when the tables it outgrew can go.
+static void atoms_remove(y_atoms_t *atoms, atom_t *atom)
+{
+  atoms_table_t *table = atoms->table;
+  u64 hole = atom->hash & table->mask;
+
+  for (atoms_table_t *it = table->smaller, *smaller; it; it = smaller)
+  {
+    smaller = it->smaller;
+    deallocate(NULL, it);
+  }
+
+  table->smaller = NULL;
+
+  while (table->slots[hole].atom != atom)
+    hole = (hole + 1) & table->mask;
+
+  for (u64 slot = (hole + 1) & table->mask; table->slots[slot].atom; slot = (slot + 1) & table->mask)
+  {
+    u64 home = table->slots[slot].hash & table->mask;
+
+    // Moved back when the hole lies between its home slot and where it is
+    if (((slot - home) & table->mask) >= ((slot - hole) & table->mask))
+    {
+      table->slots[hole] = table->slots[slot];
+      hole = slot;
+    }
+  }
+
+  table->slots[hole] = (atoms_slot_t) { 0 };
+  atoms->count--;
+
+  deallocate(NULL, atom);
+}
+
+static atom_t *held_find(held_t *held, u64 hash, const char *name, u64 length)
+{
+  if (!held->slots)
+    return NULL;
+
+  for (u64 slot = hash & held->mask;; slot = (slot + 1) & held->mask)
+  {
+    atom_t *atom = held->slots[slot];
+
+    if (!atom || (atom->hash == hash && atom->length == length && !memcmp(atom->name, name, length)))
+      return atom;
+  }
+}
+
+static void held_place(held_t *held, atom_t *atom)
+{
+  u64 slot = atom->hash & held->mask;
+
+  while (held->slots[slot])
+    slot = (slot + 1) & held->mask;
+
+  held->slots[slot] = atom;
+  held->count++;
+}
+
+static void held_add(held_t *held, atom_t *atom)
+{
+  if (!held->slots || (held->count + 1) * 2 > held->mask + 1)
+  {
+    held_t grown = { .mask = held->slots ? held->mask * 2 + 1 : HELD_MIN - 1 };
+
+    grown.slots = allocate(NULL, (grown.mask + 1) * sizeof(atom_t *));
+    memset(grown.slots, 0, (grown.mask + 1) * sizeof(atom_t *));
+
+    for (u64 i = 0; held->slots && i <= held->mask; i++)
+    {
+      if (held->slots[i])
+        held_place(&grown, held->slots[i]);
+    }
+
+    if (held->slots)
+      deallocate(NULL, held->slots);
+
+    *held = grown;
+  }
+
+  held_place(held, atom);
+}
+
+// Hands the atoms of `from` to `into`; one both hold loses the extra count,
+// which others may be adding to as this runs.
+static void held_merge(held_t *into, held_t *from)
+{
+  for (u64 i = 0; from->slots && i <= from->mask; i++)
+  {
+    atom_t *atom = from->slots[i];
+
+    if (!atom)
+      continue;
+
+    if (held_find(into, atom->hash, atom->name, atom->length))
+      __atomic_sub_fetch(&atom->units, 1, __ATOMIC_RELAXED);
+    else
+      held_add(into, atom);
+  }
+
+  if (from->slots)
+    deallocate(NULL, from->slots);
+
+  *from = (held_t) { 0 };
+}
+
+// Lets go of every atom the unit held, taking out the ones no other holds.
+static void held_drop(y_atoms_t *atoms, held_t *held)
+{
+  for (u64 i = 0; held->slots && i <= held->mask; i++)
+  {
+    atom_t *atom = held->slots[i];
+
+    if (atom && __atomic_sub_fetch(&atom->units, 1, __ATOMIC_RELAXED) == 0)
+      atoms_remove(atoms, atom);
+  }
+
+  if (held->slots)
+    deallocate(NULL, held->slots);
+
+  *held = (held_t) { 0 };
+}
+
+// Strings of a streamed unit point into a window that is reused, so the ones
+// kept in the tree are copied out; every other unit is referenced in place.
+static string_t unit_keep(unit_t *unit, string_t string)
+{
+  if (unit->storage != STORAGE_STREAM || string.string < unit->data || string.string > unit->data + unit->length)
+    return string;
+
+  char *copy = arena_push(&unit->arena, string.length);
+
+  memcpy(copy, string.string, string.length);
+  string.string = copy;
+
+  return string;
+}
+
+// Names and notes are interned as they are parsed, while still at hand. The
+// table is read without the lock, so only a name it lacks takes it, and units
+// parsed on several threads hardly ever wait on each other. Each unit counts
+// once towards every atom it holds, the first time it comes across the name.
+static string_t unit_intern(unit_t *unit, string_t name)
+{
+  u64 hash = hash_name(name.string, name.length);
+  atom_t *atom = held_find(&unit->held, hash, name.string, name.length);
+
+  if (!atom)
+  {
+    y_atoms_t *atoms = unit->context->atoms;
+
+    atom = atoms_find(atoms, hash, name.string, name.length);
+
+    if (!atom)
+    {
+      atoms_lock(atoms);
+      atom = atoms_intern(atoms, hash, name.string, name.length);
+      atoms_unlock(atoms);
+    }
+
+    __atomic_add_fetch(&atom->units, 1, __ATOMIC_RELAXED);
+    held_add(&unit->held, atom);
+  }
+
+  return (string_t) { .string = atom->name, .length = atom->length };
+}
+
+static y_note_t *parse_note(unit_t *unit)
+{
+  y_note_t head = { 0 }, *it = &head;
+
+  while (token_consume(unit, '@'))
+  {
+    token_t *name = token_expect(unit, TOKEN_TEXT);
+
+    if (!name)
+      break;
+
+    y_note_t *note = it = it->next = arena_zero(&unit->arena, sizeof(y_note_t));
+    note->name = unit_intern(unit, name->value.string);
+  }
+
+  return head.next;
+}
+
+static bool lazy_defer(unit_t *unit, y_node_t *node, u32 depth);
+
+#define ARRAY_STAGE 64
+
+// Elements of an array being read. While they share one numeric kind they are
+// kept packed, as they end up in the tree; one of another kind unpacks them.
+typedef struct stage_t
+{
+  y_kind type;       // Y_INTEGER or Y_DECIMAL while packed, Y_NONE once mixed
+  u64 length, capacity;
+  u64 *packed;       // Bits of `integer` or `decimal`, the union shares them
+  y_value_t *values; // Every element once mixed
+  y_note_t **notes;  // Notes of every element, NULL until one has some
+  u64 local[ARRAY_STAGE];
+} stage_t;
+
+static void stage_grow(stage_t *stage)
+{
+  u64 capacity = stage->capacity * 2;
+
+  if (stage->packed == stage->local)
+    stage->packed = memcpy(allocate(NULL, capacity * sizeof(u64)), stage->local, sizeof(stage->local));
+  else if (stage->packed)
+    stage->packed = reallocate(NULL, stage->packed, capacity * sizeof(u64));
+
+  if (stage->values)
+    stage->values = reallocate(NULL, stage->values, capacity * sizeof(y_value_t));
+
+  if (stage->notes)
+  {
+    stage->notes = reallocate(NULL, stage->notes, capacity * sizeof(y_note_t *));
+    memset(stage->notes + stage->capacity, 0, stage->capacity * sizeof(y_note_t *));
+  }
+
+  stage->capacity = capacity;
+}
+
+static void stage_push(stage_t *stage, y_value_t value, y_note_t *note)
+{
+  if (stage->length == stage->capacity)
+    stage_grow(stage);
+
+  if (stage->length == 0 && (value.kind == Y_INTEGER || value.kind == Y_DECIMAL))
+    stage->type = value.kind;
+
+  if (stage->type != value.kind && !stage->values)
+  {
+    stage->values = allocate(NULL, stage->capacity * sizeof(y_value_t));
+
+    for (u64 i = 0; i < stage->length; i++)
+      stage->values[i] = (y_value_t) { .kind = stage->type, .integer = stage->packed[i] };
+
+    stage->type = Y_NONE;
+  }
+
+  if (stage->values)
+    stage->values[stage->length] = value;
+  else
+    stage->packed[stage->length] = value.integer;
+
+  if (note && !stage->notes)
+    stage->notes = allocate(NULL, stage->capacity * sizeof(y_note_t *));
+
+  if (stage->notes)
+    stage->notes[stage->length] = note;
+
+  stage->length++;
+}
+
+// Length of the run of digits at `ch`.
+static u64 digits_length(const char *ch, const char *end)
+{
+  const char *it = ch;
+
+#ifdef Y_X86
+  for (; end - it >= 16; it += 16)
+  {
+    __m128i bytes = _mm_sub_epi8(_mm_loadu_si128((const __m128i *) it), _mm_set1_epi8('0'));
+    __m128i digit = _mm_cmplt_epi8(_mm_xor_si128(bytes, _mm_set1_epi8(-128)), _mm_set1_epi8(-128 + 10));
+    int mask = ~_mm_movemask_epi8(digit) & 0xFFFF;
+
+    if (mask)
+      return it - ch + __builtin_ctz(mask);
+  }
+#endif
+
+  while (it < end && is(*it, CLASS_DIGIT))
+    it++;
+
+  return it - ch;
+}
+
+#ifdef Y_X86
+static const u8 digits_keep[32] =
+{
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+#endif
+
+// Value of the `count` <= 16 digits at `ch`. With SSE2 they are read as the
+// last bytes of a 16 byte load, which may start before `ch` but not `first`,
+// and folded pairwise: 2, 4, 8 digits per lane, then the two halves.
+static u64 digits_value(const char *ch, u64 count, const char *first)
+{
+#ifdef Y_X86
+  if (ch + count - first >= 16)
+  {
+    __m128i keep   = _mm_loadu_si128((const __m128i *) (digits_keep + count));
+    __m128i bytes  = _mm_loadu_si128((const __m128i *) (ch + count - 16));
+    __m128i digits = _mm_and_si128(_mm_sub_epi8(bytes, _mm_set1_epi8('0')), keep);
+    __m128i zero   = _mm_setzero_si128();
+
+    __m128i pairs  = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(digits, zero), _mm_set1_epi32(0x0001000A)),
+                                     _mm_madd_epi16(_mm_unpackhi_epi8(digits, zero), _mm_set1_epi32(0x0001000A)));
+    __m128i quads  = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+    __m128i eights = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set1_epi32(0x00012710));
+
+    return (u64) _mm_cvtsi128_si32(eights) * 100000000 + (u32) _mm_cvtsi128_si32(_mm_srli_si128(eights, 4));
+  }
+#else
+  (void) first;
+#endif
+
+  u64 value;
+  scan_integer(&ch, ch + count, &value);
+
+  return value;
+}
+
+static const u64 pow10_integer[] =
+{
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+  1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+  1000000000000000000ULL
+};
+
+// Reads a plain number, digits with at most one `.`, the same way token_number
+// would; false for anything that needs the lexer, such as `_` or an overflow.
+static bool array_number(const char **at, const char *end, const char *first, y_value_t *value)
+{
+  const char *begin = *at, *ch = begin;
+  u64 whole = digits_length(ch, end);
+
+  ch += whole;
+
+  if (ch < end && *ch == '.')
+  {
+    u64 fraction = digits_length(ch + 1, end);
+
+    *at = ch + 1 + fraction;
+    value->kind = Y_DECIMAL;
+
+    if (whole + fraction <= 19 && whole <= 16 && fraction <= 16)
+    {
+      u64 w = digits_value(begin, whole, first) * pow10_integer[fraction] + digits_value(ch + 1, fraction, first);
+
+      // Exact, the same as the fast path of decimal_value
+      if (fraction <= 22 && w <= (1ULL << 53))
+      {
+        value->decimal = (f64) w / pow10[fraction];
+        return true;
+      }
+    }
+
+    value->decimal = decimal_value(begin, *at);
+    return true;
+  }
+
+  value->kind = Y_INTEGER;
+  *at = ch;
+
+  if (whole <= 16)
+  {
+    value->integer = digits_value(begin, whole, first);
+    return true;
+  }
+
+  return scan_integer(&begin, ch, &value->integer);
+}
+
+// The fast path of `[ 1, 2, 3 ]`: reads plain numbers straight from the text
+// into the packed stage, no tokens built. An element is only taken once a
+// comma, blank or `]` shows it has no notes; the unit is left at the first
+// one that is not taken, for the token path. Returns false if there was none.
+static bool array_scan(unit_t *unit, stage_t *stage)
+{
+  const char *data = unit->data, *end = data + unit->length;
+  const char *ch = unit->current.source.begin, *start = unit->current.source.start;
+  int line = unit->current.source.line;
+  u64 taken = stage->length;
+
+  while (ch < end && is(*ch, CLASS_DIGIT))
+  {
+    const char *at = ch, *lf = start;
+    int lines = 0;
+    y_value_t value;
+
+    if (!array_number(&at, end, data, &value) || (stage->length && stage->type != value.kind))
+      break;
+
+    // The lexer's blanks only, so a text loads alike by every path
+    for (bool comma = false; at < end; at++)
+    {
+      if (*at == '\n')
+      {
+        lines++;
+        lf = at + 1;
+      }
+      else if (*at == ',' && !comma)
+        comma = true;
+      else if (*at != ' ' && *at != '\t')
+        break;
+    }
+
+    if (at == end || (*at != ']' && !is(*at, CLASS_DIGIT)))
+      break;
+
+    if (stage->length == stage->capacity)
+      stage_grow(stage);
+
+    if (stage->length == 0)
+      stage->type = value.kind;
+
+    stage->packed[stage->length++] = value.integer;
+
+    if (stage->notes)
+      stage->notes[stage->length - 1] = NULL;
+
+    ch = at;
+    line += lines;
+    start = lf;
+
+    if (*ch == ']')
+      break;
+  }
+
+  if (stage->length == taken)
+    return false;
+
+  unit->cursor = ch - data;
+  unit->line = line;
+  unit->start = start;
+  lex_next(unit);
+
+  return true;
+}
+
+// Reads the elements of an array up to its `]`, then packs them into one
+// block of the arena: as plain u64 or f64 when all are of that kind, as
+// y_value_t otherwise, followed by their notes if any has some.
+static y_value_t parse_array(unit_t *unit)
+{
+  stage_t stage = { .type = Y_NONE, .capacity = ARRAY_STAGE };
+  bool fast = unit->storage != STORAGE_STREAM;
+  token_t *temp;
+
+  stage.packed = stage.local;
+
+  while (!token_consume(unit, ']'))
+  {
+    if (fast && !stage.values && unit->current.kind == TOKEN_NUMBER && array_scan(unit, &stage))
+      continue;
+
+    y_value_t value;
+
+    if ((temp = token_consume(unit, TOKEN_NUMBER)))
+      value = temp->value;
+    else if ((temp = token_consume(unit, TOKEN_STRING)))
+    {
+      value = temp->value;
+      value.string = unit_keep(unit, temp->value.string);
+    }
+    else
+    {
+      report(unit, unit->current.source, Y_ERROR_SYNTAX, "Expecting a number or string in array.");
+
+      // Most likely the array was never closed and this ends its node
+      if (unit->current.kind == '}' || unit->current.kind == TOKEN_NONE)
+        break;
+
+      token_eat(unit);
+      token_consume(unit, ',');
+      continue;
+    }
+
+    stage_push(&stage, value, parse_note(unit));
+    token_consume(unit, ',');
+  }
+
+  u64 length = stage.length;
+  u64 item = stage.values ? sizeof(y_value_t) : sizeof(u64);
+  y_array_t *array = arena_push(&unit->arena, sizeof(y_array_t) + length * (item + (stage.notes ? sizeof(y_note_t *) : 0)));
+
+  array->type = stage.values ? Y_NONE : stage.type;
+  array->length = length;
+  array->values = (y_value_t *) (array + 1);
+  array->notes = stage.notes ? (y_note_t **) ((char *) (array + 1) + length * item) : NULL;
+
+  memcpy(array->values, stage.values ? (void *) stage.values : (void *) stage.packed, length * item);
+
+  if (stage.notes)
+    memcpy(array->notes, stage.notes, length * sizeof(y_note_t *));
+
+  if (stage.packed != stage.local)
+    deallocate(NULL, stage.packed);
+
+  deallocate(NULL, stage.values);
+  deallocate(NULL, stage.notes);
+
+  return (y_value_t) { .kind = Y_ARRAY, .array = array };
+}
+
+#define HASH_MIN 16 // Children from which a node gets a y_hash_t
+
+// Open addressing over the children of a node, never more than half full.
+struct y_hash_t
+{
+  u64 mask;
+  u32 *tags; // High half of the hash of each slot's name, to skip most compares
+  y_node_t *slots[];
+};
+
+#define HASH_AHEAD 8 // Children whose slots are fetched while one goes in
+
+// Hashes the children of `node`, which are all in place. Of several with one
+// name only the first goes in, the one a walk of the list would find.
+static y_hash_t *hash_build(arena_t *arena, y_node_t *node)
+{
+  u64 capacity = HASH_MIN * 2;
+
+  while (capacity < (u64) node->count * 2)
+    capacity *= 2;
+
+  y_hash_t *hash = arena_zero(arena, sizeof(y_hash_t) + capacity * (sizeof(y_node_t *) + sizeof(u32)));
+  y_node_t *ahead = node->value.node;
+  u64 hashes[HASH_AHEAD];
+
+  hash->mask = capacity - 1;
+  hash->tags = (u32 *) (hash->slots + capacity);
+
+  // Big tables miss the cache on every insert, so slots are fetched early
+  for (uint i = 0; i < HASH_AHEAD && ahead; i++, ahead = ahead->next)
+  {
+    hashes[i] = atom_of(ahead->name)->hash;
+    __builtin_prefetch(&hash->slots[hashes[i] & hash->mask], 1);
+    __builtin_prefetch(&hash->tags[hashes[i] & hash->mask], 1);
+  }
+
+  uint i = 0;
+
+  for (y_node_t *it = node->value.node; it; it = it->next, i = (i + 1) % HASH_AHEAD)
+  {
+    u64 slot = hashes[i] & hash->mask;
+    u32 tag = hashes[i] >> 32;
+    y_node_t *other;
+
+    if (ahead)
+    {
+      hashes[i] = atom_of(ahead->name)->hash;
+      __builtin_prefetch(&hash->slots[hashes[i] & hash->mask], 1);
+      __builtin_prefetch(&hash->tags[hashes[i] & hash->mask], 1);
+      ahead = ahead->next;
+    }
+
+    while ((other = hash->slots[slot]))
+    {
+      if (hash->tags[slot] == tag && other->name.string == it->name.string)
+        break;
+
+      slot = (slot + 1) & hash->mask;
+    }
+
+    if (!other)
+    {
+      hash->slots[slot] = it;
+      hash->tags[slot] = tag;
+    }
+  }
+
+  return hash;
+}
+
+// `value` is hash_name of the name, which callers may have at hand already.
+static y_node_t *hash_find(y_hash_t *hash, u64 value, const char *name, u64 length)
+{
+  u64 slot = value & hash->mask;
+  y_node_t *it;
+
+  while ((it = hash->slots[slot]))
+  {
+    if (hash->tags[slot] == (u32) (value >> 32) && (u64) it->name.length == length && !memcmp(it->name.string, name, length))
+      return it;
+
+    slot = (slot + 1) & hash->mask;
+  }
+
+  return NULL;
+}
+
+// Links of a Y_LOAD_FLAT unit are only final once flattened, which hashes them.
+static void hash_node(unit_t *unit, y_node_t *node)
+{
+  if (!unit->flat && node->count >= HASH_MIN)
+    node->value.hash = hash_build(&unit->arena, node);
+}
+
+// An open `{ ... }` node and the last child appended to it.
+typedef struct frame_t
+{
+  y_node_t *node;
+  y_node_t *tail;
+} frame_t;
+
+// Steps to the `}` closing the innermost open list, over any nested ones, so
+// that parsing picks up after an error as if the list ended there.
+static void parse_skip(unit_t *unit)
+{
+  u64 open = 0;
+
+  for (; unit->current.kind != TOKEN_NONE; lex_next(unit))
+  {
+    if (unit->current.kind == '{')
+      open++;
+    else if (unit->current.kind == '}')
+    {
+      if (!open)
+        return;
+
+      open--;
+    }
+  }
+}
+
+// Closes every list that ends here; otherwise its next child follows. Input
+// running out closes them all, keeping the nodes read so far.
+static u32 parse_close(unit_t *unit, frame_t *stack, u32 depth)
+{
+  while (depth)
+  {
+    if (token_consume(unit, '}'))
+    {
+      y_node_t *node = stack[--depth].node;
+
+      hash_node(unit, node);
+      node->note = parse_note(unit);
+      continue;
+    }
+
+    if (unit->current.kind == TOKEN_NONE)
+    {
+      report(unit, unit->current.source, Y_ERROR_UNCLOSED, "Expecting ending to node list.");
+      return 0;
+    }
+
+    break;
+  }
+
+  return depth;
+}
+
+// Parses a node and its whole subtree without recursing: open lists live on
+// an explicit stack that grows on the heap, bounded by `unit->depth`. Returns
+// NULL, past the offending token, when there is no node to start with.
+static y_node_t *parse_node(unit_t *unit)
+{
+  frame_t *stack = NULL;
+  u32 depth = 0, capacity = 0;
+  y_node_t *root = NULL;
+  token_t *temp;
+
+  do
+  {
+    token_t *name = token_expect(unit, TOKEN_TEXT);
+
+    if (!name)
+    {
+      if (!depth)
+      {
+        token_eat(unit);
+        break;
+      }
+
+      parse_skip(unit);
+      depth = parse_close(unit, stack, depth);
+      continue;
+    }
+
+    y_node_t *node = arena_zero(unit->flat ? &unit->scratch : &unit->arena, sizeof(y_node_t));
+
+    unit->nodes++;
+
+    node->name = unit_intern(unit, name->value.string);
+
+    if (depth)
+    {
+      frame_t *top = &stack[depth - 1];
+
+      if (top->tail)
+        top->tail->next = node;
+      else
+        top->node->value.node = node;
+
+      top->tail = node;
+      top->node->count++;
+      node->parent = top->node;
+    }
+    else
+      root = node;
+
+    if (token_consume(unit, '{'))
+    {
+      node->value.kind = Y_NODE;
+
+      // A body nested too deep is skipped whole, leaving the node empty
+      if (unit->depth && unit->level + depth == unit->depth)
+      {
+        report(unit, unit->previous.source, Y_ERROR_DEPTH, "Nodes nested deeper than %u levels.", unit->depth);
+        parse_skip(unit);
+        token_consume(unit, '}');
+        node->note = parse_note(unit);
+      }
+      // The body of a unit's head is parsed right away, y_load hands it out
+      else if (unit->lazy && unit->level + depth && lazy_defer(unit, node, depth))
+        node->note = parse_note(unit);
+      else
+      {
+        if (depth == capacity)
+        {
+          capacity = capacity ? capacity * 2 : 64;
+          stack = reallocate(NULL, stack, capacity * sizeof(frame_t));
+        }
+
+        stack[depth++] = (frame_t) { .node = node };
+      }
+    }
+    else
+    {
+      if ((temp = token_consume(unit, TOKEN_NUMBER)))
+        node->value = temp->value;
+      else if ((temp = token_consume(unit, TOKEN_STRING)))
+      {
+        node->value = temp->value;
+        node->value.string = unit_keep(unit, temp->value.string);
+      }
+      else if (token_consume(unit, '['))
+        node->value = parse_array(unit);
+
+      node->note = parse_note(unit);
+    }
+
+    depth = parse_close(unit, stack, depth);
+  }
+  while (depth);
+
+  deallocate(NULL, stack);
+  return root;
+}
+
+// Copies the linked tree into one pre-order array, filling in subtree sizes
+// so that `node + node->size` is the next sibling. The walk follows parent
+// links instead of a stack; `size` of each linked node holds its index in the
+// array until the copy is done with it.
+static y_node_t *flatten(unit_t *unit, y_node_t *head)
+{
+  y_node_t *array = arena_push(&unit->arena, unit->nodes * sizeof(y_node_t));
+  y_node_t *it = head;
+  u32 i = 0;
+
+  while (it)
+  {
+    y_node_t *node = &array[i];
+
+    *node = *it;
+    it->size = i++;
+    node->parent = it == head ? NULL : &array[it->parent->size];
+
+    if (it->value.kind == Y_NODE && it->value.node)
+    {
+      node->value.node = &array[i];
+      it = it->value.node;
+      continue;
+    }
+
+    // Leave `it` and every ancestor whose last child it was.
+    for (;;)
+    {
+      node = &array[it->size];
+      node->size = i - it->size;
+      node->next = NULL;
+
+      // Its children are final now, up to the last one's `next`
+      if (node->count >= HASH_MIN)
+        node->value.hash = hash_build(&unit->arena, node);
+
+      if (it == head)
+      {
+        it = NULL;
+        break;
+      }
+
+      if (it->next)
+      {
+        node->next = &array[i];
+        it = it->next;
+        break;
+      }
+
+      it = it->parent;
+    }
+  }
+
+  arena_drop(&unit->scratch);
+  return array;
+}
+
+// Runs `run` once for each of `count` items on up to `threads` threads, 0 for
+// one per core; the calling thread takes items too.
+typedef struct pool_t
+{
+  void (*run)(void *data, uint i);
+  void *data;
+  uint count;
+  uint next; // Next item to claim, taken with an atomic add
+} pool_t;
+
+static void *pool_work(void *data)
+{
+  pool_t *pool = data;
+  uint i;
+
+  while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count)
+    pool->run(pool->data, i);
+
+  return NULL;
+}
+
+static uint pool_threads(uint threads)
+{
+#ifdef Y_POSIX
+  if (threads == 0)
+  {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+
+  return threads;
+#else
+  return 1;
+#endif
+}
+
+static void pool_start(pool_t *pool, uint threads)
+{
+#ifdef Y_X86
+  vector_resolve(); // Once here, not racing in every worker
+#endif
+
+  threads = pool_threads(threads);
+
+  if (threads > pool->count)
+    threads = pool->count;
+
+#ifdef Y_POSIX
+  pthread_t *workers = threads > 1 ? allocate(NULL, (threads - 1) * sizeof(pthread_t)) : NULL;
+  uint started = 0;
+
+  while (started + 1 < threads && !pthread_create(&workers[started], NULL, pool_work, pool))
+    started++;
+
+  pool_work(pool);
+
+  for (uint i = 0; i < started; i++)
+    pthread_join(workers[i], NULL);
+
+  deallocate(NULL, workers);
+#else
+  pool_work(pool);
+#endif
+}
+
+// Moves every chunk of `from` into `into`, behind the chunk `into` allocates from.
+static void arena_join(arena_t *into, arena_t *from)
+{
+  chunk_t *tail = from->chunk;
+
+  if (!tail)
+    return;
+
+  if (!into->chunk)
+  {
+    into->chunk = from->chunk;
+    from->chunk = NULL;
+    return;
+  }
+
+  while (tail->next)
+    tail = tail->next;
+
+  tail->next = into->chunk->next;
+  into->chunk->next = from->chunk;
+  from->chunk = NULL;
+}
+
+#define SPLIT_MIN   (1024 * 1024) // Bytes of body below which a root is parsed serially
+#define SPLIT_RATIO 4             // Chunks per thread, to even out uneven subtrees
+
+// Where a chunk of the root's children begins: the first byte of a child's
+// name, which opens its line, the start of that line and its number.
+typedef struct cut_t
+{
+  u64 offset, start;
+  int line;
+} cut_t;
+
+#define BRACE_OPEN (~(u64) 0) // A `{` that a `]` closes, or nothing
+
+// Where a `{` within the bodies of a Y_LOAD_LAZY unit closes, found by the
+// scan that deferred the outermost of them and kept, in order of `begin`, so
+// that entering a body never scans it again.
+typedef struct brace_t
+{
+  u64 begin; // Offset after the `{`
+  cut_t close;
+} brace_t;
+
+// A chunk of the root's children, parsed by a unit of its own that shares the
+// data and stops at the next cut.
+typedef struct part_t
+{
+  unit_t unit;
+  y_node_t *head, *tail;
+  u32 count;
+} part_t;
+
+static bool split_special(char ch)
+{
+  switch (ch)
+  {
+  case '\n': case '\"': case '/': case '@':
+  case '{': case '}': case '[': case ']':
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Steps to the next byte split_scan has to look at: a line feed, quote,
+// slash, `@` or bracket.
+static const char *split_skip(const char *ch, const char *end)
+{
+#ifdef Y_X86
+  for (; end - ch >= 16; ch += 16)
+  {
+    __m128i bytes = _mm_loadu_si128((const __m128i *) ch);
+    __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20)); // `[` and `]` to `{` and `}`
+    __m128i hit   = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\"')));
+
+    hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('/')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('@'))));
+    hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))));
+
+    int mask = _mm_movemask_epi8(hit);
+
+    if (mask)
+      return ch + __builtin_ctz(mask);
+  }
+#endif
+
+  while (ch < end && !split_special(*ch))
+    ch++;
+
+  return ch;
+}
+
+// Steps over the spaces, tabs and carriage returns that indent a line.
+static const char *split_indent(const char *ch, const char *end)
+{
+#ifdef Y_X86
+  for (; end - ch >= 16; ch += 16)
+  {
+    __m128i bytes = _mm_loadu_si128((const __m128i *) ch);
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')));
+    int mask = ~_mm_movemask_epi8(_mm_or_si128(blank, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')))) & 0xFFFF;
+
+    if (mask)
+      return ch + __builtin_ctz(mask);
+  }
+#endif
+
+  while (ch < end && (*ch == ' ' || *ch == '\t' || *ch == '\r'))
+    ch++;
+
+  return ch;
+}
+
+// Brace-matches the root's body from `at` without building tokens, cutting
+// it once every `step` bytes before a child name that opens its line. The
+// last cut is the root's closing `}`; returns the number of cuts, or 0 when
+// the body never closes and the serial parser should report why. With
+// `braces`, where each `{` in the body closes is added to them.
+static uint split_scan(unit_t *unit, cut_t at, u64 step, cut_t *cuts, uint limit, buf_t *braces)
+{
+  const char *data = unit->data, *end = data + unit->length;
+  const char *ch = data + at.offset;
+  u64 target = at.offset + step;
+  uint count = 0, depth = 0;
+  bool note = false; // An `@` still waits for its name, which is no child
+  u64 recorded = braces ? braces->length : 0;
+  buf_t *open = braces ? buf_create(0, sizeof(u64), NULL) : NULL; // Index in `braces` of each open bracket
+
+  cuts[count++] = at;
+
+  while ((ch = split_skip(ch, end)) < end)
+  {
+    switch (*ch++)
+    {
+    case '\n':
+      at.line++;
+      at.start = ch - data;
+      ch = split_indent(ch, end);
+
+      if (ch < end && !note && depth == 0 && (u64) (ch - data) >= target && count + 1 < limit && is(*ch, CLASS_START))
+      {
+        at.offset = ch - data;
+        cuts[count++] = at;
+        target = at.offset + step;
+      }
+
+      note = note && ch < end && (*ch == '\n' || *ch == '/');
+      break;
+    case '/':
+      if (ch < end && *ch == '/')
+      {
+        const char *lf = memchr(ch, '\n', end - ch);
+        ch = lf ? lf : end;
+      }
+      break;
+    case '\"':
+      while (ch < end)
+      {
+        ch = quote_vector(ch, end);
+
+        if (ch >= end || *ch == '\n')
+          break;
+
+        if (*ch == '\"')
+        {
+          ch++;
+          break;
+        }
+
+        ch += *ch == '\\' && ch + 1 < end && ch[1] != '\n' ? 2 : 1;
+      }
+
+      note = false;
+      break;
+    case '@':
+      while (ch < end && (*ch == ' ' || *ch == '\t' || *ch == '\r'))
+        ch++;
+
+      note = ch < end && (*ch == '\n' || *ch == '/');
+      break;
+    case '{':
+    case '[':
+      if (braces)
+      {
+        u64 index = ch[-1] == '{' ? braces->length : BRACE_OPEN;
+
+        if (index != BRACE_OPEN)
+          buf_push(braces, &(brace_t) { .begin = ch - data, .close.offset = BRACE_OPEN });
+
+        buf_push(open, &index);
+      }
+
+      depth++;
+      note = false;
+      break;
+    case '}':
+    case ']':
+      if (depth == 0)
+      {
+        if (ch[-1] != '}')
+        {
+          ch = end;
+          break;
+        }
+
+        at.offset = ch - 1 - data;
+        cuts[count++] = at;
+        buf_delete(open);
+        return count;
+      }
+
+      if (braces)
+      {
+        u64 index = *(u64 *) buf_get(open, --open->length);
+
+        // A `{` closed by `]` is left open, for lazy_defer to parse it now
+        if (index != BRACE_OPEN && ch[-1] == '}')
+          ((brace_t *) buf_get(braces, index))->close = (cut_t) { ch - 1 - data, at.start, at.line };
+      }
+
+      depth--;
+      note = false;
+      break;
+    }
+  }
+
+  // Nothing is kept of a body that never closes
+  if (braces)
+    braces->length = recorded;
+
+  buf_delete(open);
+  return 0;
+}
+
+// The brace whose body begins at `offset`, if a scan went over it.
+static brace_t *brace_find(buf_t *braces, u64 offset)
+{
+  u64 low = 0, high = braces->length;
+
+  while (low < high)
+  {
+    u64 middle = low + (high - low) / 2;
+    brace_t *brace = buf_get(braces, middle);
+
+    if (brace->begin == offset)
+      return brace;
+
+    if (brace->begin < offset)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return NULL;
+}
+
+// Brace-matches the body of `node`, whose `{` was just read, and records it for
+// lazy_enter instead of parsing it; the unit carries on from the `}`. Returns
+// false for a body that never closes, which is parsed now to report why. Only
+// the outermost bodies are scanned, nested ones close where that scan found.
+static bool lazy_defer(unit_t *unit, y_node_t *node, u32 depth)
+{
+  source_t open = unit->previous.source;
+  cut_t cuts[2], at = { open.end - unit->data, open.start - unit->data, open.line };
+  buf_t *braces = unit->owner->braces;
+  brace_t *brace = brace_find(braces, at.offset);
+
+  if (brace)
+  {
+    if (brace->close.offset == BRACE_OPEN)
+      return false;
+
+    cuts[0] = at;
+    cuts[1] = brace->close;
+  }
+  else
+  {
+    // Kept only past the last brace known, which keeps them in order
+    bool last = !braces->length || ((brace_t *) buf_get(braces, braces->length - 1))->begin < at.offset;
+
+    if (split_scan(unit, at, unit->length, cuts, 2, last ? braces : NULL) != 2)
+      return false;
+  }
+
+  y_lazy_t *lazy = arena_push(&unit->arena, sizeof(y_lazy_t));
+
+  lazy->unit = unit->owner;
+  lazy->begin = cuts[0].offset;
+  lazy->end = cuts[1].offset;
+  lazy->start = cuts[0].start;
+  lazy->line = cuts[0].line;
+  lazy->level = unit->level + depth + 1;
+  node->lazy = lazy;
+
+  unit->cursor = cuts[1].offset;
+  unit->start = unit->data + cuts[1].start;
+  unit->line = cuts[1].line;
+  lex_next(unit);
+  token_expect(unit, '}');
+
+  return true;
+}
+
+// Parses the body of a lazy node once; readers racing to it wait on the lock
+// of its unit, which also guards the arena the children go to.
+static y_node_t *lazy_enter(y_node_t *node)
+{
+  y_lazy_t *lazy = __atomic_load_n(&node->lazy, __ATOMIC_ACQUIRE);
+
+  if (!lazy)
+    return node->value.kind == Y_NODE ? node->value.node : NULL;
+
+  unit_t *owner = lazy->unit;
+
+#ifdef Y_POSIX
+  pthread_mutex_lock(&owner->lock);
+#endif
+
+  if (node->lazy)
+  {
+    unit_t unit = { 0 };
+    y_node_t *tail = NULL;
+
+    unit.name = owner->name;
+    unit.data = owner->data;
+    unit.length = lazy->end;
+    unit.cursor = lazy->begin;
+    unit.start = owner->data + lazy->start;
+    unit.line = lazy->line;
+    unit.storage = owner->storage;
+    unit.depth = owner->depth;
+    unit.lazy = true;
+    unit.level = lazy->level;
+    unit.owner = owner;
+    unit.context = owner->context;
+    unit.verbose = owner->verbose;
+    unit.arena = owner->arena;
+    unit.held = owner->held;
+
+    lex_next(&unit);
+
+    // A body holding nothing but blanks and comments has no children
+    while (unit.current.kind != TOKEN_NONE)
+    {
+      y_node_t *child = parse_node(&unit);
+
+      if (!child)
+        continue;
+
+      child->parent = node;
+
+      if (tail)
+        tail->next = child;
+      else
+        node->value.node = child;
+
+      tail = child;
+      node->count++;
+    }
+
+    // A broken body keeps the children that did parse
+    diags_move(owner->context, &unit);
+    hash_node(&unit, node);
+
+    owner->arena = unit.arena;
+    owner->held = unit.held;
+    owner->nodes += unit.nodes;
+    __atomic_store_n(&node->lazy, NULL, __ATOMIC_RELEASE);
+  }
+
+#ifdef Y_POSIX
+  pthread_mutex_unlock(&owner->lock);
+#endif
+
+  return node->value.node;
+}
+
+static void split_run(void *data, uint i)
+{
+  part_t *part = (part_t *) data + i;
+  unit_t *unit = &part->unit;
+
+  lex_next(unit);
+
+  while (unit->current.kind != TOKEN_NONE)
+  {
+    y_node_t *node = parse_node(unit);
+
+    if (!node)
+      continue;
+
+    if (part->tail)
+      part->tail->next = node;
+    else
+      part->head = node;
+
+    part->tail = node;
+    part->count++;
+  }
+}
+
+// Parses a root of the form `name { ... }` by cutting its children into
+// chunks that are parsed on threads and joined in order. Returns NULL,
+// leaving the unit untouched, when the input is too small or not of that form,
+// or has errors, which a serial parse then reports as it would have anyway.
+static y_node_t *parse_split(unit_t *unit)
+{
+  unit_t probe = *unit;
+  cut_t cuts[256 + 1];
+  uint limit = unit->threads * SPLIT_RATIO + 1;
+
+  if (unit->lazy || unit->threads < 2 || unit->depth == 1 || unit->length < 2 * SPLIT_MIN)
+    return NULL;
+
+  if (limit > sizeof(cuts) / sizeof(*cuts))
+    limit = sizeof(cuts) / sizeof(*cuts);
+
+  string_t name = unit->current.value.string;
+
+  // The probe only looks ahead; whatever it runs into, the serial parse reports
+  probe.diags = NULL;
+  probe.verbose = false;
+
+  bool named = token_consume(&probe, TOKEN_TEXT) && token_consume(&probe, '{') && probe.current.kind == TOKEN_TEXT;
+
+  if (!named || probe.diags)
+  {
+    diags_drop(probe.diags);
+    return NULL;
+  }
+
+  source_t first = probe.current.source;
+  cut_t at = { first.begin - unit->data, first.start - unit->data, first.line };
+  u64 step = (unit->length - at.offset) / (limit - 1);
+
+  uint count = split_scan(unit, at, step > SPLIT_MIN ? step : SPLIT_MIN, cuts, limit, NULL);
+
+  if (count < 3)
+    return NULL;
+
+  part_t *parts = allocate(NULL, (count - 1) * sizeof(part_t));
+  pool_t pool = { .run = split_run, .data = parts, .count = count - 1 };
+
+  for (uint i = 0; i + 1 < count; i++)
+  {
+    unit_t *part = &parts[i].unit;
+
+    part->name = unit->name;
+    part->context = unit->context;
+    part->data = unit->data;
+    part->length = cuts[i + 1].offset;
+    part->cursor = cuts[i].offset;
+    part->start = unit->data + cuts[i].start;
+    part->line = cuts[i].line;
+    part->storage = STORAGE_BORROWED;
+    part->flat = unit->flat;
+    part->depth = unit->depth ? unit->depth - 1 : 0;
+    part->arena.allocator = unit->arena.allocator;
+    part->scratch.allocator = unit->scratch.allocator;
+  }
+
+  pool_start(&pool, unit->threads);
+
+  bool failed = false;
+
+  for (uint i = 0; i + 1 < count; i++)
+    failed |= parts[i].unit.diags != NULL;
+
+  if (failed)
+  {
+    for (uint i = 0; i + 1 < count; i++)
+    {
+      arena_drop(&parts[i].unit.arena);
+      arena_drop(&parts[i].unit.scratch);
+      diags_drop(parts[i].unit.diags);
+      held_merge(&unit->held, &parts[i].unit.held);
+    }
+
+    deallocate(NULL, parts);
+    return NULL;
+  }
+
+  probe.diags = unit->diags;
+  probe.verbose = unit->verbose;
+  *unit = probe;
+
+  y_node_t *root = arena_zero(unit->flat ? &unit->scratch : &unit->arena, sizeof(y_node_t));
+  y_node_t *tail = NULL;
+
+  root->name = unit_intern(unit, name);
+  root->value.kind = Y_NODE;
+  unit->nodes++;
+
+  for (uint i = 0; i + 1 < count; i++)
+  {
+    part_t *part = &parts[i];
+
+    for (y_node_t *it = part->head; it; it = it->next)
+      it->parent = root;
+
+    if (tail)
+      tail->next = part->head;
+    else
+      root->value.node = part->head;
+
+    tail = part->tail;
+    root->count += part->count;
+    unit->nodes += part->unit.nodes;
+
+    arena_join(&unit->arena, &part->unit.arena);
+    arena_join(&unit->scratch, &part->unit.scratch);
+    held_merge(&unit->held, &part->unit.held);
+  }
+
+  deallocate(NULL, parts);
+
+  // Carry on serially from the root's `}`
+  unit->cursor = cuts[count - 1].offset;
+  unit->start = unit->data + cuts[count - 1].start;
+  unit->line = cuts[count - 1].line;
+  lex_next(unit);
+
+  token_expect(unit, '}');
+  hash_node(unit, root);
+  root->note = parse_note(unit);
+
+  return root;
+}
+
+static y_node_t *parse_unit(unit_t *unit)
+{
+  y_node_t *node = parse_split(unit);
+
+  if (!node)
+    node = parse_node(unit);
+
+  token_expect(unit, TOKEN_NONE);
+
+  if (unit->flat && !unit->diags)
+    node = flatten(unit, node);
+
+  return node;
+}
+
+static bool unit_read(unit_t *unit, cstr path)
+{
+  fs_item_t *file = fs_open(path);
+  char *data;
+
+  if (file->kind != FS_FILE)
+  {
+    fs_close(file);
+    return false;
+  }
+
+  unit->length = fs_read(file, &data, 0);
+  unit->data = data;
+  unit->storage = STORAGE_HEAP;
+  fs_close(file);
+
+  return true;
+}
+
+static bool unit_map(unit_t *unit, cstr path)
+{
+#ifdef Y_POSIX
+  struct stat info;
+  void *data;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  if (fstat(fd, &info) || info.st_size == 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED)
+    return false;
+
+  unit->data = data;
+  unit->length = info.st_size;
+  unit->storage = STORAGE_MAPPED;
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+static cstr unit_name(cstr name)
+{
+  if (!name)
+    return NULL;
+
+  u64 length = strlen(name);
+  char *copy = allocate(NULL, length + 1);
+
+  memcpy(copy, name, length);
+  copy[length] = 0;
+
+  return copy;
+}
+
+static y_node_t *unit_parse(yctx_t *y, unit_t *unit)
+{
+  unit->start = unit->data;
+
+  unit->context = y;
+  unit->depth = y->depth;
+  unit->verbose = y->verbose;
+  unit->arena.allocator = y->allocator;
+  unit->scratch.allocator = y->allocator;
+
+  lex_next(unit);
+  unit->head = parse_unit(unit);
+
+  if (unit->storage == STORAGE_STREAM)
+  {
+    deallocate(NULL, (void *) unit->data);
+    unit->data = NULL;
+    unit->length = 0;
+  }
+
+  return unit->head;
+}
+
+static void unit_drop(unit_t *unit)
+{
+  switch (unit->storage)
+  {
+  case STORAGE_HEAP:
+    deallocate(NULL, (void *) unit->data);
+    break;
+  case STORAGE_MAPPED:
+#ifdef Y_POSIX
+    munmap((void *) unit->data, unit->length);
+#endif
+    break;
+  case STORAGE_BORROWED:
+  case STORAGE_STREAM:
+    break;
+  }
+
+  // The scratch nodes of a Y_LOAD_FLAT load that failed were never flattened
+  arena_drop(&unit->arena);
+  arena_drop(&unit->scratch);
+  diags_drop(unit->diags);
+
+  if (unit->context)
+    held_drop(unit->context->atoms, &unit->held);
+
+  if (unit->braces)
+    buf_delete(unit->braces);
+
+  deallocate(NULL, (void *) unit->name);
+
+#ifdef Y_POSIX
+  if (unit->lazy)
+    pthread_mutex_destroy(&unit->lock);
+#endif
+
+  deallocate(NULL, unit);
+}
+
+#define CACHE_SLOTS  4096 // Paths y_find remembers between loads
+#define CACHE_PROBES 8    // Slots tried before a path is not remembered
+#define CACHE_KEY    256  // Longest path remembered
+
+typedef struct entry_t
+{
+  u64 hash;
+  y_node_t *node; // NULL for a path that finds nothing
+  u64 length;
+  char key[];
+} entry_t;
+
+// Filled by readers racing each other, so slots are only ever set once, with
+// a compare-and-swap, until a load or unload empties them all. The winner then
+// copies the hash next to the slot, where probes can skip it without a miss.
+struct y_cache_t
+{
+  entry_t *slots[CACHE_SLOTS];
+  u64 hashes[CACHE_SLOTS];
+};
+
+// `path` with every run of blanks made one space and none at either end, the
+// same for each way of writing one path; 0 when it does not fit in `key`.
+static u64 cache_key(cstr path, char *key)
+{
+  u64 length = 0;
+  bool gap = false;
+
+  for (; *path; path++)
+  {
+    if (*path == ' ' || *path == '\t' || *path == '\n')
+    {
+      gap = length > 0;
+      continue;
+    }
+
+    if (length + gap >= CACHE_KEY)
+      return 0;
+
+    if (gap)
+      key[length++] = ' ';
+
+    key[length++] = *path;
+    gap = false;
+  }
+
+  return length;
+}
+
+// Sets `room` when a miss found a free slot, for cache_put to take.
+static entry_t *cache_get(y_cache_t *cache, u64 hash, const char *key, u64 length, bool *room)
+{
+  for (u64 i = 0; i < CACHE_PROBES; i++)
+  {
+    u64 slot = (hash + i) % CACHE_SLOTS;
+    entry_t *entry = __atomic_load_n(&cache->slots[slot], __ATOMIC_ACQUIRE);
+
+    if (!entry)
+    {
+      *room = true;
+      return NULL;
+    }
+
+    u64 other = __atomic_load_n(&cache->hashes[slot], __ATOMIC_RELAXED);
+
+    if (other && other != hash)
+      continue;
+
+    if (entry->hash == hash && entry->length == length && !memcmp(entry->key, key, length))
+      return entry;
+  }
+
+  return NULL;
+}
+
+static void cache_put(y_cache_t *cache, u64 hash, const char *key, u64 length, y_node_t *node)
+{
+  entry_t *entry = allocate(NULL, sizeof(entry_t) + length);
+
+  entry->hash = hash;
+  entry->node = node;
+  entry->length = length;
+  memcpy(entry->key, key, length);
+
+  for (u64 i = 0; i < CACHE_PROBES; i++)
+  {
+    u64 slot = (hash + i) % CACHE_SLOTS;
+    entry_t *other = NULL;
+
+    if (__atomic_compare_exchange_n(&cache->slots[slot], &other, entry, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+    {
+      __atomic_store_n(&cache->hashes[slot], hash, __ATOMIC_RELAXED);
+      return;
+    }
+
+    // Another reader got there first
+    if (other->hash == hash && other->length == length && !memcmp(other->key, key, length))
+      break;
+  }
+
+  deallocate(NULL, entry);
+}
+
+static void cache_clear(y_cache_t *cache)
+{
+  for (u64 i = 0; i < CACHE_SLOTS; i++)
+  {
+    deallocate(NULL, cache->slots[i]);
+    cache->slots[i] = NULL;
+    cache->hashes[i] = 0;
+  }
+}
+
+// Appends a parsed unit to the context, or drops it with its problems handed
+// over; only ever called from one thread.
+static y_node_t *unit_link(yctx_t *y, unit_t *unit)
+{
+  y_node_t *head = unit->head;
+
+  if (unit->diags)
+  {
+    diags_move(y, unit);
+    unit_drop(unit);
+    return NULL;
+  }
+
+  y->heads = (y->heads ? y->heads : &y->root)->next = head;
+  buf_push(y->units, &unit);
+  cache_clear(y->cache);
+
+  return head;
+}
+
+yctx_t y_create(void)
+{
+  yctx_t ctx = { 0 };
+
+  ctx.units = buf_create(0, sizeof(unit_t *), NULL);
+  ctx.diags = buf_create(0, sizeof(y_diag_t), NULL);
+  ctx.cache = allocate(NULL, sizeof(y_cache_t));
+  ctx.atoms = atoms_create();
+
+  return ctx;
+}
+
+void y_unload(yctx_t *y, y_node_t *head)
+{
+  cache_clear(y->cache);
+
+  for (y_node_t *it = &y->root; it->next; it = it->next)
+  {
+    if (it->next != head)
+      continue;
+
+    it->next = head->next;
+
+    if (y->heads == head)
+      y->heads = it == &y->root ? NULL : it;
+    break;
+  }
+
+  // The last unit fills the hole, so the list only holds units still loaded
+  for (u64 i = 0; i < y->units->length; i++)
+  {
+    unit_t **unit = buf_get(y->units, i);
+
+    if ((*unit)->head == head)
+    {
+      unit_drop(*unit);
+      *unit = *(unit_t **) buf_get(y->units, --y->units->length);
+      break;
+    }
+  }
+}
+
+void y_delete(yctx_t *y)
+{
+  for (u64 i = 0; i < y->units->length; i++)
+    unit_drop(*(unit_t **) buf_get(y->units, i));
+
+  buf_delete(y->units);
+  diags_drop(y->diags);
+  cache_clear(y->cache);
+  deallocate(NULL, y->cache);
+  atoms_delete(y->atoms);
+}
+
+y_node_t *y_load(yctx_t *y, cstr path)
+{
+  return y_load_with(y, path, 0);
+}
+
+// Returns false, with the problem reported, for a file that can not be read.
+static bool unit_open(yctx_t *y, unit_t *unit, cstr path, y_flag flags)
+{
+  bool loaded = (flags & Y_LOAD_MAPPED) && unit_map(unit, path);
+
+  if (!loaded)
+    loaded = unit_read(unit, path);
+
+  unit->name = unit_name(path);
+  unit->verbose = y->verbose;
+
+  if (!loaded)
+  {
+    report(unit, (source_t) { 0 }, Y_ERROR_FILE, "Could not read the file.");
+    return false;
+  }
+
+  unit->flat = flags & Y_LOAD_FLAT;
+
+  if (flags & Y_LOAD_PARALLEL)
+    unit->threads = pool_threads(y->threads);
+
+  if (flags & Y_LOAD_LAZY)
+  {
+    unit->flat = false;
+    unit->lazy = true;
+    unit->owner = unit;
+    unit->braces = buf_create(0, sizeof(brace_t), NULL);
+
+#ifdef Y_POSIX
+    pthread_mutex_init(&unit->lock, NULL);
+#endif
+  }
+
+  return true;
+}
+
+y_node_t *y_load_with(yctx_t *y, cstr path, y_flag flags)
+{
+  unit_t *unit = allocate(NULL, sizeof(unit_t));
+
+  if (unit_open(y, unit, path, flags))
+    unit_parse(y, unit);
+
+  return unit_link(y, unit);
+}
+
+typedef struct batch_t
+{
+  yctx_t *y;
+  cstr   *paths;
+  unit_t **units;
+} batch_t;
+
+static void batch_run(void *data, uint i)
+{
+  batch_t *batch = data;
+
+  unit_t *unit = batch->units[i] = allocate(NULL, sizeof(unit_t));
+
+  if (unit_open(batch->y, unit, batch->paths[i], Y_LOAD_MAPPED))
+    unit_parse(batch->y, unit);
+}
+
+y_node_t *y_load_many(yctx_t *y, cstr *paths, uint count, uint threads)
+{
+  batch_t batch = { .y = y, .paths = paths };
+  pool_t pool = { .run = batch_run, .data = &batch, .count = count };
+
+  if (count == 0)
+    return NULL;
+
+  batch.units = allocate(NULL, count * sizeof(unit_t *));
+  pool_start(&pool, threads);
+
+  y_node_t *first = NULL;
+
+  // Linked in the order of `paths`, whichever worker finished first
+  for (uint i = 0; i < count; i++)
+  {
+    y_node_t *head = unit_link(y, batch.units[i]);
+
+    if (i == 0)
+      first = head;
+  }
+
+  deallocate(NULL, batch.units);
+
+  return first;
+}
+
+y_node_t *y_load_stream(yctx_t *y, y_reader read, void *user, cstr name)
+{
+  unit_t *unit = allocate(NULL, sizeof(unit_t));
+
+  unit->name = unit_name(name);
+  unit->capacity = STREAM_WINDOW;
+  unit->data = allocate(NULL, unit->capacity);
+  unit->storage = STORAGE_STREAM;
+  unit->read = read;
+  unit->user = user;
+
+  unit_parse(y, unit);
+
+  return unit_link(y, unit);
+}
+
+#ifdef Y_POSIX
+static u64 fd_read(void *user, char *buffer, u64 size)
+{
+  ssize_t got;
+
+  do
+    got = read(*(int *) user, buffer, size);
+  while (got < 0 && errno == EINTR);
+
+  return got > 0 ? got : 0;
+}
+
+y_node_t *y_load_fd(yctx_t *y, int fd, cstr name)
+{
+  return y_load_stream(y, fd_read, &fd, name);
+}
+#endif
+
+y_node_t *y_parse_buffer(yctx_t *y, const char *data, u64 length, cstr name)
+{
+  unit_t *unit = allocate(NULL, sizeof(unit_t));
+
+  unit->name = unit_name(name);
+  unit->data = data;
+  unit->length = length;
+  unit->storage = STORAGE_BORROWED;
+
+  unit_parse(y, unit);
+
+  return unit_link(y, unit);
+}
+
+// The first of the siblings from `first` named so, through the hash of their
+// parent when it has one; `value` is hash_name of the name. Otherwise the name
+// is looked up among the atoms once, so the walk compares pointers: siblings
+// are entered, their names interned, and a name with no atom is not there.
+static y_node_t *find_child(yctx_t *y, y_node_t *first, y_hash_t *hash, u64 value, const char *name, u64 length)
+{
+  if (hash)
+    return hash_find(hash, value, name, length);
+
+  atom_t *atom = atoms_find(y->atoms, value, name, length);
+
+  if (!atom)
+    return NULL;
+
+  for (y_node_t *it = first; it; it = it->next)
+  {
+    if (it->name.string == atom->name)
+      return it;
+  }
+
+  return NULL;
+}
+
+static y_node_t *find_in(yctx_t *y, y_node_t *current, unit_t *unit)
+{
+  y_hash_t *hash = NULL;
+  token_t *temp;
+
+  while ((temp = token_consume(unit, TOKEN_TEXT)))
+  {
+    string_t name = temp->value.string;
+    y_node_t *it  = find_child(y, current, hash, hash_name(name.string, name.length), name.string, name.length);
+
+    if (!it)
+      return NULL;
+
+    if (unit->current.kind == TOKEN_NONE)
+    {
+      lazy_enter(it);
+      return it;
+    }
+
+    if (it->value.kind != Y_NODE)
+      return NULL;
+
+    current = lazy_enter(it);
+    hash = it->value.hash;
+  }
+
+  return NULL;
+}
+
+// A path with characters no name holds finds nothing. Either way the result
+// is remembered, so the next lookup of the path is one probe of the cache.
+y_node_t *y_find(yctx_t *y, cstr path)
+{
+  char key[CACHE_KEY];
+  u64 length = cache_key(path, key), hash = 0;
+  bool room = false;
+
+  if (length)
+  {
+    hash = hash_name(key, length);
+    entry_t *entry = cache_get(y->cache, hash, key, length, &room);
+
+    if (entry)
+      return entry->node;
+  }
+
+  unit_t unit = { .data = path, .length = strlen(path) };
+
+  lex_next(&unit);
+
+  y_node_t *node = find_in(y, y->root.next, &unit);
+
+  if (unit.diags)
+  {
+    diags_drop(unit.diags);
+    node = NULL;
+  }
+
+  if (room)
+    cache_put(y->cache, hash, key, length, node);
+
+  return node;
+}
+
+// One name of a compiled path; the names are copied in behind the steps.
+struct y_step_t
+{
+  string_t name;
+  u64 hash;
+};
+
+// Paths are lexed like y_find lexes them, so blanks, line feeds and `//`
+// comments between names are all the same to every way of walking one.
+static void path_open(unit_t *unit, cstr path)
+{
+  *unit = (unit_t) { .data = path, .length = strlen(path) };
+  lex_next(unit);
+}
+
+// The next name of a path; false at the end of it, or at anything that is
+// not a name, where the unit is left so that path_close can tell.
+static bool path_next(unit_t *unit, string_t *name)
+{
+  token_t *temp = token_consume(unit, TOKEN_TEXT);
+
+  if (!temp)
+    return false;
+
+  *name = temp->value.string;
+  return true;
+}
+
+// Whether the path held nothing but names that lexed cleanly.
+static bool path_close(unit_t *unit)
+{
+  bool whole = unit->current.kind == TOKEN_NONE && !unit->diags;
+
+  diags_drop(unit->diags);
+  return whole;
+}
+
+// A path y_find would fail to lex, or whose tokens are not all names,
+// compiles to one with no steps.
+y_path_t y_path_compile(cstr path)
+{
+  y_path_t compiled = { 0 };
+  unit_t unit;
+  string_t name;
+  u64 count = 0, length = 0;
+
+  for (path_open(&unit, path); path_next(&unit, &name);)
+  {
+    count++;
+    length += name.length;
+  }
+
+  if (!path_close(&unit) || count == 0 || count > UINT32_MAX)
+    return compiled;
+
+  y_step_t *steps = allocate(NULL, count * sizeof(y_step_t) + length);
+  char *names = (char *) (steps + count);
+
+  for (path_open(&unit, path); path_next(&unit, &name);)
+  {
+    y_step_t *step = &steps[compiled.count++];
+
+    memcpy(names, name.string, name.length);
+
+    step->name.string = names;
+    step->name.length = name.length;
+    step->hash = hash_name(names, name.length);
+
+    names += name.length;
+  }
+
+  compiled.steps = steps;
+  return compiled;
+}
+
+// Walks the same way as y_find, minus the lexing and the cache: each step
+// is one probe of its parent's hash, or a walk of the children when small.
+y_node_t *y_find_path(yctx_t *y, const y_path_t *path)
+{
+  y_node_t *current = y->root.next;
+  y_hash_t *hash = NULL;
+
+  for (u32 i = 0; i < path->count; i++)
+  {
+    const y_step_t *step = &path->steps[i];
+    y_node_t *it = find_child(y, current, hash, step->hash, step->name.string, step->name.length);
+
+    if (!it)
+      return NULL;
+
+    if (i + 1 == path->count)
+    {
+      lazy_enter(it);
+      return it;
+    }
+
+    if (it->value.kind != Y_NODE)
+      return NULL;
+
+    current = lazy_enter(it);
+    hash = it->value.hash;
+  }
+
+  return NULL;
+}
+
+void y_path_delete(y_path_t *path)
+{
+  if (path->steps)
+    deallocate(NULL, path->steps);
+
+  path->count = 0;
+  path->steps = NULL;
+}
+
+#define PREFIXES_MIN 64 // Slots of the first table of prefixes y_find_many keeps
+
+// A prefix of one of the paths walked so far: its last name, the prefix that
+// name follows and the node they led to, NULL if none. `key` hashes them all.
+typedef struct prefix_t
+{
+  u64 key;
+  u32 parent; // Index of the prefix before the name plus one, 0 at the top
+  string_t name;
+  y_node_t *node;
+} prefix_t;
+
+// Every prefix resolved in one call of y_find_many, in the order they were
+// added; a slot holds an index into `items` plus one, 0 when free.
+typedef struct prefixes_t
+{
+  prefix_t *items;
+  u32 *slots;
+  u32 count, capacity;
+  u64 mask;
+} prefixes_t;
+
+// Two prefixes are the same when they end in the same name after the same
+// prefix, so comparing one name per probe compares the whole of them.
+static u32 prefixes_find(prefixes_t *table, u64 key, u32 parent, string_t name)
+{
+  if (!table->slots)
+    return 0;
+
+  for (u64 slot = key & table->mask;; slot = (slot + 1) & table->mask)
+  {
+    u32 index = table->slots[slot];
+    prefix_t *prefix = index ? &table->items[index - 1] : NULL;
+
+    if (!prefix || (prefix->key == key && prefix->parent == parent && prefix->name.length == name.length && !memcmp(prefix->name.string, name.string, name.length)))
+      return index;
+  }
+}
+
+static void prefixes_place(prefixes_t *table, u32 index)
+{
+  u64 slot = table->items[index - 1].key & table->mask;
+
+  while (table->slots[slot])
+    slot = (slot + 1) & table->mask;
+
+  table->slots[slot] = index;
+}
+
+static u32 prefixes_add(prefixes_t *table, prefix_t prefix)
+{
+  if (table->count == table->capacity)
+  {
+    table->capacity = table->capacity ? table->capacity * 2 : PREFIXES_MIN / 2;
+    table->items = reallocate(NULL, table->items, table->capacity * sizeof(prefix_t));
+  }
+
+  table->items[table->count++] = prefix;
+
+  if (!table->slots || table->count * 2 > table->mask + 1)
+  {
+    u64 mask = table->slots ? table->mask * 2 + 1 : PREFIXES_MIN - 1;
+
+    if (table->slots)
+      deallocate(NULL, table->slots);
+
+    table->mask = mask;
+    table->slots = allocate(NULL, (mask + 1) * sizeof(u32));
+    memset(table->slots, 0, (mask + 1) * sizeof(u32));
+
+    for (u32 i = 1; i < table->count; i++)
+      prefixes_place(table, i);
+  }
+
+  prefixes_place(table, table->count);
+  return table->count;
+}
+
+// The child of `above` named so, or the one at the top level when `top`.
+static y_node_t *find_under(yctx_t *y, y_node_t *above, bool top, u64 value, string_t name)
+{
+  if (top)
+    return find_child(y, y->root.next, NULL, value, name.string, name.length);
+
+  if (!above || above->value.kind != Y_NODE)
+    return NULL;
+
+  return find_child(y, lazy_enter(above), above->value.hash, value, name.string, name.length);
+}
+
+// Each prefix of the paths is walked once per call, whichever paths share it
+// and in whatever order they come: a name already walked after the same
+// prefix is one probe of a table. The last name of a path is looked up in
+// its parent directly, so the table only holds names paths go on from.
+uint y_find_many(yctx_t *y, cstr *paths, uint count, y_node_t **out)
+{
+  prefixes_t table = { 0 };
+  uint found = 0;
+
+  for (uint i = 0; i < count; i++)
+  {
+    y_node_t *node = NULL, *above = NULL;
+    unit_t unit;
+    string_t name, next;
+    u64 key = 0;
+    u32 parent = 0;
+
+    path_open(&unit, paths[i]);
+
+    for (bool more = path_next(&unit, &name); more; name = next)
+    {
+      u64 value = hash_name(name.string, name.length);
+
+      if (!(more = path_next(&unit, &next)))
+      {
+        node = find_under(y, above, !parent, value, name);
+        break;
+      }
+
+      key = (key ^ value) * 0x9e3779b97f4a7c15;
+      key ^= key >> 32;
+
+      u32 index = prefixes_find(&table, key, parent, name);
+
+      if (!index)
+        index = prefixes_add(&table, (prefix_t) { .key = key, .parent = parent, .name = name, .node = find_under(y, above, !parent, value, name) });
+
+      above = table.items[index - 1].node;
+      parent = index;
+    }
+
+    if (!path_close(&unit))
+      node = NULL;
+    else if (node)
+    {
+      lazy_enter(node);
+      found++;
+    }
+
+    out[i] = node;
+  }
+
+  if (table.items)
+    deallocate(NULL, table.items);
+
+  if (table.slots)
+    deallocate(NULL, table.slots);
+
+  return found;
+}
+
+y_node_t *y_iter(y_node_t *begin, y_node_t **iter)
+{
+  if (*iter == NULL)
+    *iter = begin;
+
+  if ((*iter)->next == NULL)
+    return NULL;
+
+  *iter = (*iter)->next;
+  lazy_enter(*iter);
+
+  return *iter;
+}
+
+y_node_t *y_enter(y_node_t *node)
+{
+  return lazy_enter(node);
+}
+
+static const void *array_items(y_node_t *node, y_kind type, u64 *length)
+{
+  if (!node || node->value.kind != Y_ARRAY || node->value.array->type != type)
+  {
+    *length = 0;
+    return NULL;
+  }
+
+  *length = node->value.array->length;
+  return node->value.array->values;
+}
+
+const u64 *y_integers(y_node_t *node, u64 *length)
+{
+  return array_items(node, Y_INTEGER, length);
+}
+
+const f64 *y_decimals(y_node_t *node, u64 *length)
+{
+  return array_items(node, Y_DECIMAL, length);
+}
+
+const y_value_t *y_values(y_node_t *node, u64 *length)
+{
+  return array_items(node, Y_NONE, length);
+}
+
+const y_diag_t *y_diagnostics(yctx_t *y, u64 *count)
+{
+  *count = y->diags->length;
+  return y->diags->length ? buf_get(y->diags, 0) : NULL;
+}
+
+void y_clear_diagnostics(yctx_t *y)
+{
+  for (u64 i = 0; i < y->diags->length; i++)
+    deallocate(NULL, (void *) ((y_diag_t *) buf_get(y->diags, i))->message);
+
+  y->diags->length = 0;
+}
+
+// The note is looked up among the atoms of the node's notes once, so the walk
+// compares pointers; a name with no atom is on no node.
+y_note_t *y_has(y_node_t *node, string_t note)
+{
+  if (!node->note)
+    return NULL;
+
+  y_atoms_t *atoms = atom_of(node->note->name)->atoms;
+  atom_t *atom = atoms_find(atoms, hash_name(note.string, note.length), note.string, note.length);
+
+  if (!atom)
+    return NULL;
+
+  for (y_note_t *it = node->note; it; it = it->next)
+  {
+    if (it->name.string == atom->name)
+      return it;
+  }
+
+  return NULL;
+}
+
+y_note_t *y_has_atom(y_node_t *node, u32 atom)
+{
+  for (y_note_t *it = node->note; it; it = it->next)
+  {
+    if (atom_of(it->name)->id == atom)
+      return it;
   }
 
   return NULL;
+}
+
+u32 y_node_atom(const y_node_t *node)
+{
+  return atom_of(node->name)->id;
+}
+
+u32 y_note_atom(const y_note_t *note)
+{
+  return atom_of(note->name)->id;
+}
+
+u32 y_atom(yctx_t *y, string_t name)
+{
+  atom_t *atom = atoms_find(y->atoms, hash_name(name.string, name.length), name.string, name.length);
+
+  return atom ? atom->id : 0;
 }
\ No newline at end of file
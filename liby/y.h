@@ -9,9 +9,16 @@
 #define Y_VERSION "0.1"
 
 typedef struct y_value_t y_value_t;
+typedef struct y_array_t y_array_t;
 typedef struct y_note_t  y_note_t;
 typedef struct y_node_t  y_node_t;
 typedef struct yctx_t    yctx_t;
+typedef struct y_lazy_t  y_lazy_t;
+typedef struct y_diag_t  y_diag_t;
+typedef struct y_hash_t  y_hash_t;
+typedef struct y_cache_t y_cache_t;
+typedef struct y_step_t  y_step_t;
+typedef struct y_atoms_t y_atoms_t;
 
 typedef enum y_kind
 {
@@ -20,23 +27,81 @@ typedef enum y_kind
   Y_NODE,
   Y_STRING,
   Y_INTEGER,
-  Y_DECIMAL
+  Y_DECIMAL,
+  Y_ARRAY
 } y_kind;
 
+// Fills `buffer` with up to `size` bytes of input; returns 0 once it runs out.
+typedef u64 (*y_reader)(void *user, char *buffer, u64 size);
+
+typedef enum y_flag
+{
+  Y_LOAD_MAPPED   = 1 << 0, // Map the file read-only; nodes point into the mapping
+  Y_LOAD_FLAT     = 1 << 1, // Store the nodes in one pre-order array, see y_node_t::size
+  Y_LOAD_PARALLEL = 1 << 2, // Cut a large root's children into chunks parsed on yctx_t::threads
+  Y_LOAD_LAZY     = 1 << 3, // Only brace-match `{ ... }` bodies, parsing each once it is entered;
+                            // errors in a body are reported then. FLAT and PARALLEL are ignored
+} y_flag;
+
+typedef enum y_error
+{
+  Y_ERROR_NONE = 0,
+
+  Y_ERROR_FILE,      // Could not be opened or read
+  Y_ERROR_CHARACTER, // A byte no token starts with
+  Y_ERROR_STRING,    // Unterminated, or broken by a new line
+  Y_ERROR_ESCAPE,    // Unknown `\x` or malformed `\uXXXX`
+  Y_ERROR_NUMBER,    // A second `.`, or an integer past 64 bits
+  Y_ERROR_SYNTAX,    // A token where it does not belong
+  Y_ERROR_DEPTH,     // Nested deeper than yctx_t::depth
+  Y_ERROR_UNCLOSED,  // Input ends inside a `{ ... }`
+} y_error;
+
+// One problem found while loading; lines count from 1, columns from 0.
+struct y_diag_t
+{
+  y_error code;
+  cstr file;      // Name the unit was loaded under, NULL if it had none
+  cstr message;
+  uint line, column;
+  u64 begin, end; // Bytes of the input it spans
+};
+
 struct y_value_t
 {
   y_kind kind;
 
   union
   {
-    y_node_t *node;
-    y_value_t *list;
+    struct
+    {
+      y_node_t *node;
+      y_hash_t *hash; // Children by name, for nodes with enough of them that
+                      // y_find would rather not walk the list
+    };
+    y_array_t *array;
     string_t string;
     u64 integer;
     f64 decimal;
   };
 };
 
+// `[ 1, 2, 3 ]`; elements are numbers or strings, commas between them optional.
+struct y_array_t
+{
+  y_kind type;      // Y_INTEGER or Y_DECIMAL when packed into `integers` or `decimals`,
+                    // Y_NONE for `values` of mixed kinds
+  u64 length;
+  y_note_t **notes; // Notes of each element, NULL when none has any
+
+  union
+  {
+    u64 *integers;
+    f64 *decimals;
+    y_value_t *values;
+  };
+};
+
 struct y_note_t
 {
   string_t name;
@@ -50,21 +115,99 @@ struct y_node_t
   y_value_t value;
   y_node_t *parent;
   y_node_t *next;
+
+  u32 count; // Children in `value.node`
+  u32 size;  // Nodes in this subtree, itself included; set for Y_LOAD_FLAT units,
+             // whose children start at `node + 1` and next sibling is `node + size`
+  y_lazy_t *lazy; // Body of a Y_LOAD_LAZY node not parsed yet, see y_enter
 };
 
+// A y_find path split into names and hashed once, see y_path_compile.
+typedef struct y_path_t
+{
+  u32 count;       // Names in the path, 0 for one that finds nothing
+  y_step_t *steps; // The names and their hashes, owned by the path
+} y_path_t;
+
 struct yctx_t
 {
   y_node_t root, *heads;
   buf_t   *units;
+  uint     depth;     // Deepest nesting y_load accepts, 0 for no limit
+  allocator_t *allocator; // Backs the per-unit node arenas, NULL for the default
+  uint     threads;   // Workers for Y_LOAD_PARALLEL, 0 for one per core
+  buf_t   *diags;     // y_diag_t of everything that failed to load, see y_diagnostics
+  bool     verbose;   // Also print each problem to stderr as it is found
+  y_cache_t *cache;   // What y_find resolved, by path; emptied by every load and unload
+  y_atoms_t *atoms;   // One copy of every name and note loaded, see y_atom
 };
 
 yctx_t y_create(void);
 void   y_delete(yctx_t *y);
+void   y_unload(yctx_t *y, y_node_t *head); // Frees everything the unit of `head` owns
 
 y_node_t *y_load(yctx_t *y, cstr path); // y_load "settings.y"
+y_node_t *y_load_with(yctx_t *y, cstr path, y_flag flags);
+
+// Reads and parses `count` files on up to `threads` threads, 0 for one per core,
+// mapped where possible, then links them in the order of `paths`; returns the
+// head of `paths[0]`, NULL if that one failed. A custom `allocator` must be thread-safe.
+y_node_t *y_load_many(yctx_t *y, cstr *paths, uint count, uint threads);
+
+// Parses input pulled through `read` in chunks, holding only a bounded window
+// of raw text; names and strings kept in the tree are copied out of it.
+y_node_t *y_load_stream(yctx_t *y, y_reader read, void *user, cstr name);
+
+// Reads from a file descriptor until end of file; only where y.c builds with
+// POSIX I/O.
+#if defined(__unix__) || defined(__APPLE__)
+y_node_t *y_load_fd(yctx_t *y, int fd, cstr name);
+#endif
+
+// Parses `length` bytes of `data` in place; the bytes need not be NUL-terminated
+// and are never written to, but must outlive `y`.
+y_node_t *y_parse_buffer(yctx_t *y, const char *data, u64 length, cstr name);
 y_node_t *y_find(yctx_t *y, cstr path); // y_find "settings graphics vsync"
+
+// Splits `path` as y_find would, so that y_find_path can resolve it again and
+// again without lexing it; the path does not depend on any context or load.
+y_path_t  y_path_compile(cstr path);
+y_node_t *y_find_path(yctx_t *y, const y_path_t *path);
+void      y_path_delete(y_path_t *path);
+
+// Resolves `count` paths into `out`, in the order of `paths`; leading names a
+// path shares with any path before it are not walked again, whatever the
+// order. Returns how many were found.
+uint y_find_many(yctx_t *y, cstr *paths, uint count, y_node_t **out);
+
 y_node_t *y_iter(y_node_t *begin, y_node_t **iterator);
 
+// Returns the first child of `node`, parsing its body if it was left for later
+// by Y_LOAD_LAZY; safe to race with other readers. Nodes handed out by y_load,
+// y_find and y_iter are entered already.
+y_node_t *y_enter(y_node_t *node);
+
+// Loads return NULL for input with any error, keeping none of it; the parser
+// carries on past each one, so a pass reports all it can find, in input order.
+const y_diag_t *y_diagnostics(yctx_t *y, u64 *count);
+void y_clear_diagnostics(yctx_t *y);
+
 y_note_t *y_has(y_node_t *node, string_t note);
 
+// Every name and note loaded is interned into the context: kept once, for as
+// long as a unit using it is loaded, with the `name` of each node and note
+// pointing at that copy, so two are the same name when they are the same
+// pointer. Each copy is numbered from 1 by its atom, and a number is never
+// handed out again; y_atom returns 0 for a name no unit loaded holds.
+u32 y_atom(yctx_t *y, string_t name);
+u32 y_node_atom(const y_node_t *node);
+u32 y_note_atom(const y_note_t *note);
+y_note_t *y_has_atom(y_node_t *node, u32 atom);
+
+// The elements of an array node and their count, contiguous so they can be
+// copied out in one go; NULL when `node` holds no array of that type.
+const u64 *y_integers(y_node_t *node, u64 *length);
+const f64 *y_decimals(y_node_t *node, u64 *length);
+const y_value_t *y_values(y_node_t *node, u64 *length); // Mixed or empty arrays
+
 #endif